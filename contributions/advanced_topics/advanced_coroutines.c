@@ -0,0 +1,752 @@
+/*
+ * Advanced Topic: Stackful Coroutines with an M:N Scheduler
+ * Author: gpl-gowthamchand
+ * Date: 2026-10-18
+ *
+ * Description: A small coroutine runtime that multiplexes thousands of tasks
+ * onto a few OS threads, with async sleep, timers and channels. It replaces
+ * the thread-per-activity style of advanced_threading.c, where
+ * demonstrateSynchronization() parks a whole OS thread in pthread_cond_wait
+ * and sleep(2).
+ *
+ * Prerequisites: advanced_threading.c, stacks and calling conventions
+ *
+ * Technical Details:
+ * - Each task has its own stack and a ucontext_t; switching is swapcontext()
+ *   (glibc saves the signal mask with a syscall per switch, which dominates
+ *   the measured switch cost; a hand-written switch would avoid it)
+ * - M:N scheduling: N worker threads pull runnable tasks from one shared FIFO
+ * - coSleepMs() parks the task in a min-heap of timers; idle workers wait on a
+ *   condition variable until the earliest deadline
+ * - Channels (Go-style): bounded buffer with queues of parked senders and
+ *   receivers; capacity 0 gives a rendezvous (unbuffered) channel
+ *
+ * Implementation Notes:
+ * A task must not be resumed by another worker before its context has been
+ * saved. Parking therefore happens in two steps: the task enqueues itself while
+ * holding the lock of the channel or timer heap, switches to the scheduler, and
+ * the scheduler releases that lock after swapcontext() returns. A waker needs
+ * the same lock, so it can only see fully switched-out tasks.
+ *
+ * Performance Characteristics:
+ * - Time Complexity: O(1) spawn/yield/channel op, O(log n) sleep
+ * - Space Complexity: O(tasks * TASK_STACK_SIZE)
+ * - Memory Usage: 64 KB stack per task (virtual; touched pages only)
+ *
+ * Dependencies:
+ * - pthread library (-pthread flag required for compilation)
+ * - <ucontext.h> (glibc/Linux; deprecated but available on macOS)
+ *
+ * Testing:
+ * - gcc -O2 -pthread advanced_coroutines.c -o coroutines && ./coroutines
+ * - ./coroutines 8 4000   (8 worker threads, 4000 producer + consumer tasks)
+ *
+ * Known Limitations:
+ * - No preemption: a task that never blocks or yields starves its worker
+ * - Blocking system calls inside a task block the whole worker thread
+ * - Stacks are fixed size; deep recursion inside tasks will overflow
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+
+#define TASK_STACK_SIZE (64 * 1024)
+#define MAX_WORKERS 64
+#define IDLE_WAIT_NS 10000000ull   // Re-check timers at least every 10 ms
+
+static uint64_t nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+// Runtime structures
+// ---------------------------------------------------------------------------
+
+typedef struct Task {
+    ucontext_t context;
+    void* stack;
+    void (*fn)(void*);
+    void* arg;
+    struct Task* next;        // Run queue / wait queue link
+    uint64_t wake_ns;         // Timer deadline while sleeping
+    long value;               // Value handed over by a channel
+    int ok;                   // Channel result (0 = closed)
+    int done;
+} Task;
+
+typedef struct {
+    Task* head;
+    Task* tail;
+} TaskQueue;
+
+// What the scheduler must do once the current task has switched out
+typedef enum {
+    AFTER_NOTHING,
+    AFTER_REQUEUE,            // coYield(): put the task back on the run queue
+    AFTER_UNLOCK              // Parked: release the lock that guards its wait queue
+} AfterSwitch;
+
+typedef struct {
+    ucontext_t scheduler;
+    Task* current;
+    AfterSwitch after;
+    pthread_mutex_t* unlock;
+} Worker;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t work;
+    TaskQueue run_queue;
+    atomic_long live_tasks;
+    // Timer min-heap ordered by wake_ns
+    pthread_mutex_t timer_mutex;
+    Task** timers;
+    size_t timer_count;
+    size_t timer_capacity;
+    atomic_ullong next_deadline;
+} Runtime;
+
+static Runtime g_runtime;
+static __thread Worker* t_worker = NULL;
+
+// Tasks can migrate between threads, so the thread-local must be re-read after
+// every switch; keeping the access out of line stops the compiler caching it
+__attribute__((noinline)) static Worker* currentWorker(void) {
+    return t_worker;
+}
+
+static void queuePush(TaskQueue* q, Task* t) {
+    t->next = NULL;
+    if (q->tail) {
+        q->tail->next = t;
+    } else {
+        q->head = t;
+    }
+    q->tail = t;
+}
+
+static Task* queuePop(TaskQueue* q) {
+    Task* t = q->head;
+    if (t) {
+        q->head = t->next;
+        if (q->head == NULL) {
+            q->tail = NULL;
+        }
+    }
+    return t;
+}
+
+// Make a task runnable (callable from any thread)
+static void makeRunnable(Task* t) {
+    pthread_mutex_lock(&g_runtime.mutex);
+    queuePush(&g_runtime.run_queue, t);
+    pthread_cond_signal(&g_runtime.work);
+    pthread_mutex_unlock(&g_runtime.mutex);
+}
+
+// ---------------------------------------------------------------------------
+// Task lifecycle
+// ---------------------------------------------------------------------------
+
+static void taskTrampoline(unsigned int hi, unsigned int lo) {
+    Task* t = (Task*)(((uintptr_t)hi << 32) | (uintptr_t)lo);
+    t->fn(t->arg);
+    t->done = 1;
+    // Returning resumes uc_link, which is never set; switch explicitly instead
+    swapcontext(&t->context, &currentWorker()->scheduler);
+}
+
+int coSpawn(void (*fn)(void*), void* arg) {
+    Task* t = calloc(1, sizeof(Task));
+    if (t == NULL) {
+        return -1;
+    }
+    t->stack = malloc(TASK_STACK_SIZE);
+    if (t->stack == NULL) {
+        free(t);
+        return -1;
+    }
+    t->fn = fn;
+    t->arg = arg;
+    getcontext(&t->context);
+    t->context.uc_stack.ss_sp = t->stack;
+    t->context.uc_stack.ss_size = TASK_STACK_SIZE;
+    t->context.uc_link = NULL;
+    uintptr_t p = (uintptr_t)t;
+    makecontext(&t->context, (void (*)(void))taskTrampoline, 2,
+                (unsigned int)(p >> 32), (unsigned int)(p & 0xffffffffu));
+
+    atomic_fetch_add(&g_runtime.live_tasks, 1);
+    makeRunnable(t);
+    return 0;
+}
+
+// Switch from the current task back to its worker's scheduler
+static void switchToScheduler(AfterSwitch after, pthread_mutex_t* unlock) {
+    Worker* w = currentWorker();
+    Task* t = w->current;
+    w->after = after;
+    w->unlock = unlock;
+    swapcontext(&t->context, &w->scheduler);
+    // Possibly resumed on a different worker thread from here on
+}
+
+void coYield(void) {
+    switchToScheduler(AFTER_REQUEUE, NULL);
+}
+
+// ---------------------------------------------------------------------------
+// Timers
+// ---------------------------------------------------------------------------
+
+static void timerSiftUp(size_t i) {
+    Task** h = g_runtime.timers;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (h[parent]->wake_ns <= h[i]->wake_ns) {
+            break;
+        }
+        Task* tmp = h[parent];
+        h[parent] = h[i];
+        h[i] = tmp;
+        i = parent;
+    }
+}
+
+static void timerSiftDown(size_t i) {
+    Task** h = g_runtime.timers;
+    size_t n = g_runtime.timer_count;
+    for (;;) {
+        size_t smallest = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < n && h[l]->wake_ns < h[smallest]->wake_ns) {
+            smallest = l;
+        }
+        if (r < n && h[r]->wake_ns < h[smallest]->wake_ns) {
+            smallest = r;
+        }
+        if (smallest == i) {
+            return;
+        }
+        Task* tmp = h[smallest];
+        h[smallest] = h[i];
+        h[i] = tmp;
+        i = smallest;
+    }
+}
+
+void coSleepMs(long ms) {
+    Task* t = currentWorker()->current;
+    t->wake_ns = nowNs() + (uint64_t)ms * 1000000ull;
+
+    pthread_mutex_lock(&g_runtime.timer_mutex);
+    if (g_runtime.timer_count == g_runtime.timer_capacity) {
+        size_t capacity = g_runtime.timer_capacity ? g_runtime.timer_capacity * 2 : 256;
+        Task** grown = realloc(g_runtime.timers, capacity * sizeof(Task*));
+        if (grown == NULL) {
+            pthread_mutex_unlock(&g_runtime.timer_mutex);
+            coYield(); // Out of memory: degrade to a yield
+            return;
+        }
+        g_runtime.timers = grown;
+        g_runtime.timer_capacity = capacity;
+    }
+    g_runtime.timers[g_runtime.timer_count++] = t;
+    timerSiftUp(g_runtime.timer_count - 1);
+    atomic_store(&g_runtime.next_deadline, g_runtime.timers[0]->wake_ns);
+    switchToScheduler(AFTER_UNLOCK, &g_runtime.timer_mutex);
+}
+
+// Move every expired timer to the run queue; returns the next deadline (0 = none)
+static uint64_t fireTimers(void) {
+    uint64_t now = nowNs();
+    if (atomic_load(&g_runtime.next_deadline) > now) {
+        return atomic_load(&g_runtime.next_deadline);
+    }
+    if (pthread_mutex_trylock(&g_runtime.timer_mutex) != 0) {
+        return now + IDLE_WAIT_NS / 10; // Another worker is firing timers
+    }
+    while (g_runtime.timer_count > 0 && g_runtime.timers[0]->wake_ns <= now) {
+        Task* t = g_runtime.timers[0];
+        g_runtime.timers[0] = g_runtime.timers[--g_runtime.timer_count];
+        timerSiftDown(0);
+        makeRunnable(t);
+    }
+    uint64_t next = g_runtime.timer_count ? g_runtime.timers[0]->wake_ns : UINT64_MAX;
+    atomic_store(&g_runtime.next_deadline, next);
+    pthread_mutex_unlock(&g_runtime.timer_mutex);
+    return next == UINT64_MAX ? 0 : next;
+}
+
+// ---------------------------------------------------------------------------
+// Scheduler
+// ---------------------------------------------------------------------------
+
+static void* workerMain(void* arg) {
+    Worker* w = arg;
+    t_worker = w;
+
+    for (;;) {
+        uint64_t next_deadline = fireTimers();
+
+        pthread_mutex_lock(&g_runtime.mutex);
+        Task* t = queuePop(&g_runtime.run_queue);
+        if (t == NULL) {
+            if (atomic_load(&g_runtime.live_tasks) == 0) {
+                pthread_cond_broadcast(&g_runtime.work);
+                pthread_mutex_unlock(&g_runtime.mutex);
+                return NULL;
+            }
+            // Idle: sleep until work arrives or the next timer is due
+            uint64_t until = nowNs() + IDLE_WAIT_NS;
+            if (next_deadline != 0 && next_deadline < until) {
+                until = next_deadline;
+            }
+            struct timespec ts;
+            // pthread_cond_timedwait uses CLOCK_REALTIME by default
+            clock_gettime(CLOCK_REALTIME, &ts);
+            uint64_t delta = until > nowNs() ? until - nowNs() : 0;
+            ts.tv_sec += (time_t)(delta / 1000000000ull);
+            ts.tv_nsec += (long)(delta % 1000000000ull);
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&g_runtime.work, &g_runtime.mutex, &ts);
+            pthread_mutex_unlock(&g_runtime.mutex);
+            continue;
+        }
+        pthread_mutex_unlock(&g_runtime.mutex);
+
+        w->current = t;
+        w->after = AFTER_NOTHING;
+        swapcontext(&w->scheduler, &t->context);
+        w->current = NULL;
+
+        if (t->done) {
+            free(t->stack);
+            free(t);
+            if (atomic_fetch_sub(&g_runtime.live_tasks, 1) == 1) {
+                pthread_mutex_lock(&g_runtime.mutex);
+                pthread_cond_broadcast(&g_runtime.work);
+                pthread_mutex_unlock(&g_runtime.mutex);
+            }
+        } else if (w->after == AFTER_REQUEUE) {
+            makeRunnable(t);
+        } else if (w->after == AFTER_UNLOCK) {
+            pthread_mutex_unlock(w->unlock);
+        }
+    }
+}
+
+// Run all spawned tasks (and the tasks they spawn) on `threads` workers
+void coRun(int threads) {
+    pthread_t tids[MAX_WORKERS];
+    Worker workers[MAX_WORKERS];
+
+    for (int i = 0; i < threads; i++) {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        if (pthread_create(&tids[i], NULL, workerMain, &workers[i]) != 0) {
+            fprintf(stderr, "Error creating worker thread %d\n", i);
+            exit(1);
+        }
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+    }
+}
+
+void coInit(void) {
+    memset(&g_runtime, 0, sizeof(g_runtime));
+    pthread_mutex_init(&g_runtime.mutex, NULL);
+    pthread_cond_init(&g_runtime.work, NULL);
+    pthread_mutex_init(&g_runtime.timer_mutex, NULL);
+    atomic_init(&g_runtime.live_tasks, 0);
+    atomic_init(&g_runtime.next_deadline, UINT64_MAX);
+}
+
+// ---------------------------------------------------------------------------
+// Channels
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    pthread_mutex_t mutex;
+    long* buffer;
+    size_t capacity;
+    size_t count;
+    size_t head;
+    int closed;
+    TaskQueue senders;        // Parked senders; value is in task->value
+    TaskQueue receivers;      // Parked receivers
+} Channel;
+
+Channel* chanCreate(size_t capacity) {
+    Channel* ch = calloc(1, sizeof(Channel));
+    if (ch == NULL) {
+        return NULL;
+    }
+    if (capacity > 0) {
+        ch->buffer = malloc(capacity * sizeof(long));
+        if (ch->buffer == NULL) {
+            free(ch);
+            return NULL;
+        }
+    }
+    ch->capacity = capacity;
+    pthread_mutex_init(&ch->mutex, NULL);
+    return ch;
+}
+
+void chanDestroy(Channel* ch) {
+    pthread_mutex_destroy(&ch->mutex);
+    free(ch->buffer);
+    free(ch);
+}
+
+// Send a value; parks the task while the channel is full.
+// Returns 0 if the channel is closed.
+int chanSend(Channel* ch, long value) {
+    pthread_mutex_lock(&ch->mutex);
+    if (ch->closed) {
+        pthread_mutex_unlock(&ch->mutex);
+        return 0;
+    }
+
+    // A parked receiver means the buffer is empty: hand over directly
+    Task* receiver = queuePop(&ch->receivers);
+    if (receiver) {
+        receiver->value = value;
+        receiver->ok = 1;
+        pthread_mutex_unlock(&ch->mutex);
+        makeRunnable(receiver);
+        return 1;
+    }
+
+    if (ch->count < ch->capacity) {
+        ch->buffer[(ch->head + ch->count) % ch->capacity] = value;
+        ch->count++;
+        pthread_mutex_unlock(&ch->mutex);
+        return 1;
+    }
+
+    // Full: park until a receiver takes the value
+    Task* self = currentWorker()->current;
+    self->value = value;
+    queuePush(&ch->senders, self);
+    switchToScheduler(AFTER_UNLOCK, &ch->mutex);
+    return self->ok;
+}
+
+// Receive a value; parks the task while the channel is empty.
+// Returns 0 once the channel is closed and drained.
+int chanRecv(Channel* ch, long* value) {
+    pthread_mutex_lock(&ch->mutex);
+
+    if (ch->count > 0) {
+        *value = ch->buffer[ch->head];
+        ch->head = (ch->head + 1) % ch->capacity;
+        ch->count--;
+        // Room was made: move one parked sender's value into the buffer
+        Task* sender = queuePop(&ch->senders);
+        if (sender) {
+            ch->buffer[(ch->head + ch->count) % ch->capacity] = sender->value;
+            ch->count++;
+            sender->ok = 1;
+        }
+        pthread_mutex_unlock(&ch->mutex);
+        if (sender) {
+            makeRunnable(sender);
+        }
+        return 1;
+    }
+
+    // Unbuffered channel: take directly from a parked sender
+    Task* sender = queuePop(&ch->senders);
+    if (sender) {
+        *value = sender->value;
+        sender->ok = 1;
+        pthread_mutex_unlock(&ch->mutex);
+        makeRunnable(sender);
+        return 1;
+    }
+
+    if (ch->closed) {
+        pthread_mutex_unlock(&ch->mutex);
+        return 0;
+    }
+
+    Task* self = currentWorker()->current;
+    queuePush(&ch->receivers, self);
+    switchToScheduler(AFTER_UNLOCK, &ch->mutex);
+    *value = self->value;
+    return self->ok;
+}
+
+// Close the channel; parked receivers and senders wake up with 0
+void chanClose(Channel* ch) {
+    pthread_mutex_lock(&ch->mutex);
+    ch->closed = 1;
+    TaskQueue wake = ch->receivers;
+    ch->receivers.head = ch->receivers.tail = NULL;
+    for (Task* t = ch->senders.head; t; ) {
+        Task* next = t->next;
+        t->ok = 0;
+        queuePush(&wake, t);
+        t = next;
+    }
+    ch->senders.head = ch->senders.tail = NULL;
+    pthread_mutex_unlock(&ch->mutex);
+
+    for (Task* t = wake.head; t; ) {
+        Task* next = t->next;
+        t->ok = 0;
+        makeRunnable(t);
+        t = next;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Demo 1: synchronization without blocking OS threads
+// ---------------------------------------------------------------------------
+
+static void waitingTask(void* arg) {
+    Channel* ready = arg;
+    long shared_data;
+    printf("Waiting task: waiting for value...\n");
+    if (chanRecv(ready, &shared_data)) {
+        printf("Waiting task: value received, shared_data = %ld\n", shared_data);
+    }
+}
+
+static void signalingTask(void* arg) {
+    Channel* ready = arg;
+    coSleepMs(200); // Simulate some work without holding a thread
+    printf("Signaling task: sending shared_data = 42\n");
+    chanSend(ready, 42);
+}
+
+static void demonstrateSynchronization(void) {
+    printf("=== Coroutine Synchronization Demo ===\n");
+    Channel* ready = chanCreate(0);
+    if (ready == NULL) {
+        printf("Memory allocation failed!\n");
+        return;
+    }
+    coSpawn(waitingTask, ready);
+    coSpawn(signalingTask, ready);
+    coRun(1); // Both tasks share a single OS thread
+    chanDestroy(ready);
+}
+
+// ---------------------------------------------------------------------------
+// Demo 2: thousands of producer/consumer tasks on a few threads
+// ---------------------------------------------------------------------------
+
+#define ITEMS_PER_PRODUCER 20
+
+typedef struct {
+    Channel* channel;
+    atomic_int producers_left;
+    atomic_long produced_sum;
+    atomic_long consumed_sum;
+    atomic_long consumed_count;
+} Pipeline;
+
+typedef struct {
+    Pipeline* pipeline;
+    int id;
+} ProducerArg;
+
+static void producerTask(void* arg) {
+    ProducerArg* p = arg;
+    for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+        long item = (long)p->id * 100 + i;
+        chanSend(p->pipeline->channel, item);
+        atomic_fetch_add(&p->pipeline->produced_sum, item);
+        if (i % 5 == 4) {
+            coSleepMs(1 + p->id % 3); // Async pause, the worker keeps running others
+        }
+    }
+    // The last producer closes the channel so consumers can finish
+    if (atomic_fetch_sub(&p->pipeline->producers_left, 1) == 1) {
+        chanClose(p->pipeline->channel);
+    }
+}
+
+static void consumerTask(void* arg) {
+    Pipeline* pipeline = arg;
+    long item;
+    while (chanRecv(pipeline->channel, &item)) {
+        atomic_fetch_add(&pipeline->consumed_sum, item);
+        atomic_fetch_add(&pipeline->consumed_count, 1);
+    }
+}
+
+static void demonstrateProducerConsumer(int threads, int tasks) {
+    printf("\n=== Coroutine Producer-Consumer Demo ===\n");
+    int producers = tasks / 2;
+    int consumers = tasks - producers;
+    Pipeline pipeline;
+    ProducerArg* args = malloc((size_t)producers * sizeof(ProducerArg));
+
+    pipeline.channel = chanCreate(64);
+    if (args == NULL || pipeline.channel == NULL) {
+        printf("Memory allocation failed!\n");
+        free(args);
+        return;
+    }
+    atomic_init(&pipeline.producers_left, producers);
+    atomic_init(&pipeline.produced_sum, 0);
+    atomic_init(&pipeline.consumed_sum, 0);
+    atomic_init(&pipeline.consumed_count, 0);
+
+    for (int i = 0; i < consumers; i++) {
+        coSpawn(consumerTask, &pipeline);
+    }
+    for (int i = 0; i < producers; i++) {
+        args[i].pipeline = &pipeline;
+        args[i].id = i;
+        coSpawn(producerTask, &args[i]);
+    }
+
+    uint64_t start = nowNs();
+    coRun(threads);
+    double elapsed_ms = (nowNs() - start) / 1e6;
+
+    printf("%d producers + %d consumers on %d threads: %ld items in %.1f ms\n",
+           producers, consumers, threads, atomic_load(&pipeline.consumed_count), elapsed_ms);
+    printf("Checksum produced=%ld consumed=%ld (%s)\n",
+           atomic_load(&pipeline.produced_sum), atomic_load(&pipeline.consumed_sum),
+           atomic_load(&pipeline.produced_sum) == atomic_load(&pipeline.consumed_sum)
+               ? "match" : "MISMATCH");
+
+    chanDestroy(pipeline.channel);
+    free(args);
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark: coroutine handoff vs pthread condvar handoff
+// ---------------------------------------------------------------------------
+
+#define BENCH_HANDOFFS 200000
+
+typedef struct {
+    Channel* ping;
+    Channel* pong;
+    long rounds;
+} PingPong;
+
+static void pingTask(void* arg) {
+    PingPong* pp = arg;
+    long v;
+    for (long i = 0; i < pp->rounds; i++) {
+        chanSend(pp->ping, i);
+        chanRecv(pp->pong, &v);
+    }
+}
+
+static void pongTask(void* arg) {
+    PingPong* pp = arg;
+    long v;
+    for (long i = 0; i < pp->rounds; i++) {
+        chanRecv(pp->ping, &v);
+        chanSend(pp->pong, v);
+    }
+}
+
+static void yieldTask(void* arg) {
+    long rounds = *(long*)arg;
+    for (long i = 0; i < rounds; i++) {
+        coYield();
+    }
+}
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int turn;
+    long rounds;
+} CondPingPong;
+
+static void* condPingPongThread(void* arg) {
+    CondPingPong* cp = ((void**)arg)[0];
+    int me = (int)(intptr_t)((void**)arg)[1];
+    for (long i = 0; i < cp->rounds; i++) {
+        pthread_mutex_lock(&cp->mutex);
+        while (cp->turn != me) {
+            pthread_cond_wait(&cp->cond, &cp->mutex);
+        }
+        cp->turn = 1 - me;
+        pthread_cond_signal(&cp->cond);
+        pthread_mutex_unlock(&cp->mutex);
+    }
+    return NULL;
+}
+
+static void benchmarkHandoff(void) {
+    printf("\n=== Handoff Benchmark (%d round trips) ===\n", BENCH_HANDOFFS);
+
+    // Raw context switch: two tasks yielding to each other on one worker
+    long rounds = BENCH_HANDOFFS;
+    coSpawn(yieldTask, &rounds);
+    coSpawn(yieldTask, &rounds);
+    uint64_t start = nowNs();
+    coRun(1);
+    double yield_ns = (double)(nowNs() - start) / (2.0 * BENCH_HANDOFFS);
+
+    // Channel ping-pong: two switches per round trip
+    PingPong pp = {chanCreate(0), chanCreate(0), BENCH_HANDOFFS};
+    coSpawn(pingTask, &pp);
+    coSpawn(pongTask, &pp);
+    start = nowNs();
+    coRun(1);
+    double chan_ns = (double)(nowNs() - start) / (2.0 * BENCH_HANDOFFS);
+    chanDestroy(pp.ping);
+    chanDestroy(pp.pong);
+
+    // Same handoff between two OS threads through a condition variable
+    CondPingPong cp = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, BENCH_HANDOFFS};
+    pthread_t a, b;
+    void* arg_a[2] = {&cp, (void*)(intptr_t)0};
+    void* arg_b[2] = {&cp, (void*)(intptr_t)1};
+    start = nowNs();
+    pthread_create(&a, NULL, condPingPongThread, arg_a);
+    pthread_create(&b, NULL, condPingPongThread, arg_b);
+    pthread_join(a, NULL);
+    pthread_join(b, NULL);
+    double cond_ns = (double)(nowNs() - start) / (2.0 * BENCH_HANDOFFS);
+
+    printf("coroutine yield (swapcontext):   %8.1f ns per switch\n", yield_ns);
+    printf("coroutine channel handoff:       %8.1f ns per handoff\n", chan_ns);
+    printf("pthread condvar handoff:         %8.1f ns per handoff\n", cond_ns);
+}
+
+int main(int argc, char* argv[]) {
+    int threads = (argc > 1) ? atoi(argv[1]) : 4;
+    int tasks = (argc > 2) ? atoi(argv[2]) : 2000;
+
+    if (threads < 1 || threads > MAX_WORKERS || tasks < 2) {
+        fprintf(stderr, "Usage: %s [worker_threads 1-%d] [tasks >= 2]\n", argv[0], MAX_WORKERS);
+        return 1;
+    }
+
+    printf("========================================\n");
+    printf("    Coroutines and M:N Scheduling in C  \n");
+    printf("========================================\n");
+
+    coInit();
+    demonstrateSynchronization();
+    demonstrateProducerConsumer(threads, tasks);
+    benchmarkHandoff();
+
+    free(g_runtime.timers);
+    return 0;
+}
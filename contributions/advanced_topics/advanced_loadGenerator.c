@@ -0,0 +1,687 @@
+/*
+ * Advanced Topic: Rate-Controlled Load Generator for Concurrent Queues
+ * Author: gpl-gowthamchand
+ * Date: 2026-10-18
+ *
+ * Description: Drives any producer-consumer queue with a configurable open-loop
+ * load (target rate, uniform/Poisson/bursty arrivals, N producers, M consumers,
+ * fixed run duration) and records enqueue-to-dequeue latency in an
+ * HdrHistogram-style log-linear histogram
+ *
+ * Prerequisites: advanced_threading.c (producer-consumer pattern), C11 atomics
+ *
+ * Technical Details:
+ * - Queue interface (QueueOps) so any implementation can be plugged in
+ * - Two implementations: the mutex/condition-variable bounded buffer from
+ *   advanced_threading.c and a lock-free bounded MPMC ring (Vyukov)
+ * - Producers schedule arrivals on absolute deadlines (clock_nanosleep with
+ *   TIMER_ABSTIME), so pacing does not drift with the time spent enqueuing
+ * - Two latency histograms per run:
+ *     queue   = actual enqueue  -> dequeue (time spent inside the queue)
+ *     arrival = scheduled arrival -> dequeue (includes producer backlog, which
+ *               avoids the "coordinated omission" blind spot when the queue
+ *               pushes back on producers)
+ *
+ * Implementation Notes:
+ * The histogram keeps values below 256 ns exact and splits every higher power
+ * of two into 128 sub-buckets, giving < 1% relative error with ~7.5K counters.
+ * Each consumer owns a histogram; they are merged after the run, so recording
+ * is a plain increment with no sharing.
+ *
+ * Performance Characteristics:
+ * - Time Complexity: O(1) per recorded value, O(buckets) per percentile query
+ * - Space Complexity: O(buckets) per consumer
+ * - Memory Usage: ~60 KB per histogram plus the queue capacity
+ *
+ * Dependencies:
+ * - pthread library (-pthread flag required for compilation)
+ * - Math library (-lm) for Poisson inter-arrival times
+ * - POSIX clock_nanosleep
+ *
+ * Testing:
+ * - gcc -O2 -pthread advanced_loadGenerator.c -o loadGenerator -lm
+ * - ./loadGenerator -q condvar -r 200000 -a poisson -p 4 -c 2 -d 5
+ * - ./loadGenerator -q mpmc -r 50000 -a bursty -b 64 --csv > latency.csv
+ *
+ * Known Limitations:
+ * - Sleep granularity of the OS (~50 us) bounds how smooth low rates are;
+ *   at very high rates producers fall behind and the arrival histogram shows it
+ * - Queue payload is a timestamp only; real items would add copy cost
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include <sched.h>
+
+#define MAX_PRODUCERS 64
+#define MAX_CONSUMERS 64
+#define DEFAULT_CAPACITY 1024
+
+// ---------------------------------------------------------------------------
+// Time helpers
+// ---------------------------------------------------------------------------
+
+static uint64_t nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Sleep until an absolute CLOCK_MONOTONIC deadline
+static void sleepUntilNs(uint64_t deadline) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(deadline / 1000000000ull);
+    ts.tv_nsec = (long)(deadline % 1000000000ull);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {
+        // Interrupted by a signal; try again
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Log-linear latency histogram (HdrHistogram-style)
+// ---------------------------------------------------------------------------
+
+#define HIST_SUB_BITS 7
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)               // 128
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS) * HIST_SUB_COUNT + 2 * HIST_SUB_COUNT)
+
+typedef struct {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+} Histogram;
+
+static void histInit(Histogram* h) {
+    memset(h, 0, sizeof(*h));
+    h->min = UINT64_MAX;
+}
+
+// Values < 256 map to themselves; above that, index = e*128 + (v >> e)
+// where e is chosen so that (v >> e) lands in [128, 255]
+static int histIndex(uint64_t value) {
+    int msb = 63 - __builtin_clzll(value | 1);
+    int shift = msb - HIST_SUB_BITS;
+    if (shift < 0) {
+        shift = 0;
+    }
+    return shift * HIST_SUB_COUNT + (int)(value >> shift);
+}
+
+// Highest value that maps to the same bucket as index
+static uint64_t histValueAt(int index) {
+    int shift = index < HIST_SUB_COUNT ? 0 : index / HIST_SUB_COUNT - 1;
+    uint64_t mantissa = (uint64_t)(index - shift * HIST_SUB_COUNT);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+static void histRecord(Histogram* h, uint64_t value) {
+    h->counts[histIndex(value)]++;
+    h->total++;
+    h->sum += (double)value;
+    if (value < h->min) {
+        h->min = value;
+    }
+    if (value > h->max) {
+        h->max = value;
+    }
+}
+
+static void histMerge(Histogram* into, const Histogram* from) {
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        into->counts[i] += from->counts[i];
+    }
+    into->total += from->total;
+    into->sum += from->sum;
+    if (from->min < into->min) {
+        into->min = from->min;
+    }
+    if (from->max > into->max) {
+        into->max = from->max;
+    }
+}
+
+static uint64_t histPercentile(const Histogram* h, double percentile) {
+    if (h->total == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t)ceil(percentile / 100.0 * (double)h->total);
+    if (target == 0) {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= target) {
+            uint64_t value = histValueAt(i);
+            return value < h->max ? value : h->max;
+        }
+    }
+    return h->max;
+}
+
+static void histPrintSummary(const char* label, const Histogram* h) {
+    if (h->total == 0) {
+        printf("%-8s no samples\n", label);
+        return;
+    }
+    printf("%-8s count=%llu min=%.1fus mean=%.1fus p50=%.1fus p90=%.1fus "
+           "p99=%.1fus p99.9=%.1fus p99.99=%.1fus max=%.1fus\n",
+           label, (unsigned long long)h->total,
+           h->min / 1e3, h->sum / (double)h->total / 1e3,
+           histPercentile(h, 50) / 1e3, histPercentile(h, 90) / 1e3,
+           histPercentile(h, 99) / 1e3, histPercentile(h, 99.9) / 1e3,
+           histPercentile(h, 99.99) / 1e3, h->max / 1e3);
+}
+
+// HdrHistogram-like percentile distribution: value, percentile, count, 1/(1-p)
+static void histPrintCsv(const char* label, const Histogram* h) {
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        if (h->counts[i] == 0) {
+            continue;
+        }
+        seen += h->counts[i];
+        double p = (double)seen / (double)h->total;
+        printf("%s,%llu,%.6f,%llu,%.2f\n", label,
+               (unsigned long long)histValueAt(i), p,
+               (unsigned long long)seen, p < 1.0 ? 1.0 / (1.0 - p) : INFINITY);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Queue interface
+// ---------------------------------------------------------------------------
+
+// An item carries its scheduled arrival time and its actual enqueue time
+typedef struct {
+    uint64_t scheduled_ns;
+    uint64_t enqueued_ns;
+} Item;
+
+typedef struct {
+    const char* name;
+    void* (*create)(size_t capacity);
+    void (*push)(void* queue, Item item);         // Blocks while full
+    int (*pop)(void* queue, Item* item);          // Blocks; 0 once closed and empty
+    void (*close)(void* queue);                   // No more pushes will follow
+    void (*destroy)(void* queue);
+} QueueOps;
+
+// Mutex + condition variable bounded buffer (same design as advanced_threading.c)
+typedef struct {
+    Item* items;
+    size_t capacity;
+    size_t count;
+    size_t in;
+    size_t out;
+    int closed;
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} CondvarQueue;
+
+static void* condvarCreate(size_t capacity) {
+    CondvarQueue* q = calloc(1, sizeof(CondvarQueue));
+    if (q == NULL) {
+        return NULL;
+    }
+    q->items = malloc(capacity * sizeof(Item));
+    if (q->items == NULL) {
+        free(q);
+        return NULL;
+    }
+    q->capacity = capacity;
+    pthread_mutex_init(&q->mutex, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+    return q;
+}
+
+static void condvarPush(void* queue, Item item) {
+    CondvarQueue* q = queue;
+    pthread_mutex_lock(&q->mutex);
+    while (q->count == q->capacity) {
+        pthread_cond_wait(&q->not_full, &q->mutex);
+    }
+    item.enqueued_ns = nowNs();
+    q->items[q->in] = item;
+    q->in = (q->in + 1) % q->capacity;
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+static int condvarPop(void* queue, Item* item) {
+    CondvarQueue* q = queue;
+    pthread_mutex_lock(&q->mutex);
+    while (q->count == 0 && !q->closed) {
+        pthread_cond_wait(&q->not_empty, &q->mutex);
+    }
+    if (q->count == 0) {
+        pthread_mutex_unlock(&q->mutex);
+        return 0;
+    }
+    *item = q->items[q->out];
+    q->out = (q->out + 1) % q->capacity;
+    q->count--;
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->mutex);
+    return 1;
+}
+
+static void condvarClose(void* queue) {
+    CondvarQueue* q = queue;
+    pthread_mutex_lock(&q->mutex);
+    q->closed = 1;
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+static void condvarDestroy(void* queue) {
+    CondvarQueue* q = queue;
+    pthread_mutex_destroy(&q->mutex);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+    free(q->items);
+    free(q);
+}
+
+// Lock-free bounded MPMC ring: each cell has a sequence number that tells
+// producers and consumers whose turn it is (capacity must be a power of two)
+typedef struct {
+    atomic_size_t sequence;
+    Item item;
+} MpmcCell;
+
+typedef struct {
+    MpmcCell* cells;
+    size_t mask;
+    _Alignas(64) atomic_size_t head;   // Next position to enqueue
+    _Alignas(64) atomic_size_t tail;   // Next position to dequeue
+    _Alignas(64) atomic_int closed;
+} MpmcQueue;
+
+static void* mpmcCreate(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    MpmcQueue* q = aligned_alloc(64, sizeof(MpmcQueue));
+    if (q == NULL) {
+        return NULL;
+    }
+    q->cells = malloc(size * sizeof(MpmcCell));
+    if (q->cells == NULL) {
+        free(q);
+        return NULL;
+    }
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&q->cells[i].sequence, i);
+    }
+    q->mask = size - 1;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->closed, 0);
+    return q;
+}
+
+static void mpmcPush(void* queue, Item item) {
+    MpmcQueue* q = queue;
+    size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    for (;;) {
+        MpmcCell* cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                item.enqueued_ns = nowNs();
+                cell->item = item;
+                atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+                return;
+            }
+        } else if (diff < 0) {
+            sched_yield(); // Full
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        } else {
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+}
+
+static int mpmcPop(void* queue, Item* item) {
+    MpmcQueue* q = queue;
+    size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    for (;;) {
+        MpmcCell* cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                *item = cell->item;
+                atomic_store_explicit(&cell->sequence, pos + q->mask + 1,
+                                      memory_order_release);
+                return 1;
+            }
+        } else if (diff < 0) {
+            // Empty: finished if closed and still empty after the check
+            if (atomic_load_explicit(&q->closed, memory_order_acquire) &&
+                atomic_load_explicit(&q->head, memory_order_acquire) == pos) {
+                return 0;
+            }
+            sched_yield();
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        } else {
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
+    }
+}
+
+static void mpmcClose(void* queue) {
+    MpmcQueue* q = queue;
+    atomic_store_explicit(&q->closed, 1, memory_order_release);
+}
+
+static void mpmcDestroy(void* queue) {
+    MpmcQueue* q = queue;
+    free(q->cells);
+    free(q);
+}
+
+static const QueueOps g_queues[] = {
+    {"condvar", condvarCreate, condvarPush, condvarPop, condvarClose, condvarDestroy},
+    {"mpmc", mpmcCreate, mpmcPush, mpmcPop, mpmcClose, mpmcDestroy},
+};
+
+// ---------------------------------------------------------------------------
+// Load generator
+// ---------------------------------------------------------------------------
+
+typedef enum {
+    ARRIVAL_UNIFORM,
+    ARRIVAL_POISSON,
+    ARRIVAL_BURSTY
+} ArrivalKind;
+
+typedef struct {
+    const QueueOps* ops;
+    double rate;              // Total target items per second across producers
+    ArrivalKind arrival;
+    int burst;                // Items per burst for ARRIVAL_BURSTY
+    int producers;
+    int consumers;
+    double duration;          // Seconds
+    size_t capacity;
+    int csv;
+} LoadConfig;
+
+typedef struct {
+    const LoadConfig* config;
+    void* queue;
+    uint64_t start_ns;
+    uint64_t end_ns;
+} LoadRun;
+
+typedef struct {
+    LoadRun* run;
+    int id;
+    uint64_t rng;
+    uint64_t produced;
+} ProducerState;
+
+typedef struct {
+    LoadRun* run;
+    uint64_t consumed;
+    Histogram queue_latency;
+    Histogram arrival_latency;
+} ConsumerState;
+
+// xorshift64* random number in (0, 1]
+static double nextUniform(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return ((double)((x * 0x2545F4914F6CDD1Dull) >> 11) + 1.0) / 9007199254740993.0;
+}
+
+// Nanoseconds until this producer's next arrival
+static uint64_t nextGapNs(ProducerState* p, uint64_t index) {
+    const LoadConfig* cfg = p->run->config;
+    double per_producer = cfg->rate / cfg->producers;
+    double mean_gap = 1e9 / per_producer;
+
+    switch (cfg->arrival) {
+        case ARRIVAL_POISSON:
+            return (uint64_t)(-log(nextUniform(&p->rng)) * mean_gap);
+        case ARRIVAL_BURSTY:
+            // `burst` items back to back, then a gap that keeps the mean rate
+            return ((index + 1) % (uint64_t)cfg->burst == 0)
+                   ? (uint64_t)(mean_gap * cfg->burst) : 0;
+        case ARRIVAL_UNIFORM:
+        default:
+            return (uint64_t)mean_gap;
+    }
+}
+
+static void* loadProducer(void* arg) {
+    ProducerState* p = arg;
+    LoadRun* run = p->run;
+    // Stagger producers so uniform arrivals interleave instead of colliding
+    uint64_t scheduled = run->start_ns +
+                         (uint64_t)(1e9 / run->config->rate * p->id);
+
+    while (scheduled < run->end_ns) {
+        if (scheduled > nowNs()) {
+            sleepUntilNs(scheduled);
+        }
+        Item item = {scheduled, 0};
+        run->config->ops->push(run->queue, item);
+        scheduled += nextGapNs(p, p->produced);
+        p->produced++;
+    }
+    return NULL;
+}
+
+static void* loadConsumer(void* arg) {
+    ConsumerState* c = arg;
+    Item item;
+
+    while (c->run->config->ops->pop(c->run->queue, &item)) {
+        uint64_t now = nowNs();
+        histRecord(&c->queue_latency, now - item.enqueued_ns);
+        histRecord(&c->arrival_latency, now > item.scheduled_ns ? now - item.scheduled_ns : 0);
+        c->consumed++;
+    }
+    return NULL;
+}
+
+static int runLoad(const LoadConfig* cfg) {
+    LoadRun run;
+    pthread_t producer_threads[MAX_PRODUCERS];
+    pthread_t consumer_threads[MAX_CONSUMERS];
+    ProducerState* producers = calloc((size_t)cfg->producers, sizeof(ProducerState));
+    ConsumerState* consumers = calloc((size_t)cfg->consumers, sizeof(ConsumerState));
+
+    if (producers == NULL || consumers == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        free(producers);
+        free(consumers);
+        return 1;
+    }
+
+    run.config = cfg;
+    run.queue = cfg->ops->create(cfg->capacity);
+    if (run.queue == NULL) {
+        fprintf(stderr, "Error: could not create queue '%s'\n", cfg->ops->name);
+        free(producers);
+        free(consumers);
+        return 1;
+    }
+    // Leave a little time for thread start-up before the first arrival
+    run.start_ns = nowNs() + 10000000ull;
+    run.end_ns = run.start_ns + (uint64_t)(cfg->duration * 1e9);
+
+    for (int i = 0; i < cfg->consumers; i++) {
+        consumers[i].run = &run;
+        histInit(&consumers[i].queue_latency);
+        histInit(&consumers[i].arrival_latency);
+        if (pthread_create(&consumer_threads[i], NULL, loadConsumer, &consumers[i]) != 0) {
+            fprintf(stderr, "Error creating consumer thread %d\n", i);
+            exit(1);
+        }
+    }
+    for (int i = 0; i < cfg->producers; i++) {
+        producers[i].run = &run;
+        producers[i].id = i;
+        producers[i].rng = 0x9E3779B97F4A7C15ull * (uint64_t)(i + 1);
+        if (pthread_create(&producer_threads[i], NULL, loadProducer, &producers[i]) != 0) {
+            fprintf(stderr, "Error creating producer thread %d\n", i);
+            exit(1);
+        }
+    }
+
+    uint64_t produced = 0;
+    for (int i = 0; i < cfg->producers; i++) {
+        pthread_join(producer_threads[i], NULL);
+        produced += producers[i].produced;
+    }
+    cfg->ops->close(run.queue);
+
+    Histogram queue_latency, arrival_latency;
+    histInit(&queue_latency);
+    histInit(&arrival_latency);
+    uint64_t consumed = 0;
+    for (int i = 0; i < cfg->consumers; i++) {
+        pthread_join(consumer_threads[i], NULL);
+        consumed += consumers[i].consumed;
+        histMerge(&queue_latency, &consumers[i].queue_latency);
+        histMerge(&arrival_latency, &consumers[i].arrival_latency);
+    }
+    double elapsed = (double)(nowNs() - run.start_ns) / 1e9;
+
+    static const char* arrival_names[] = {"uniform", "poisson", "bursty"};
+    if (cfg->csv) {
+        printf("histogram,value_ns,percentile,total_count,one_by_one_minus_percentile\n");
+        histPrintCsv("queue", &queue_latency);
+        histPrintCsv("arrival", &arrival_latency);
+    } else {
+        printf("queue=%s arrival=%s target=%.0f/s producers=%d consumers=%d duration=%.1fs\n",
+               cfg->ops->name, arrival_names[cfg->arrival], cfg->rate,
+               cfg->producers, cfg->consumers, cfg->duration);
+        printf("produced=%llu consumed=%llu achieved=%.0f/s\n",
+               (unsigned long long)produced, (unsigned long long)consumed,
+               (double)consumed / elapsed);
+        histPrintSummary("queue", &queue_latency);
+        histPrintSummary("arrival", &arrival_latency);
+    }
+
+    cfg->ops->destroy(run.queue);
+    free(producers);
+    free(consumers);
+    return produced == consumed ? 0 : 1;
+}
+
+static void printUsage(const char* program) {
+    printf("Usage: %s [options]\n", program);
+    printf("  -q condvar|mpmc            queue implementation (default condvar)\n");
+    printf("  -r RATE                    total target items/sec (default 100000)\n");
+    printf("  -a uniform|poisson|bursty  arrival process (default poisson)\n");
+    printf("  -b N                       burst size for bursty arrivals (default 32)\n");
+    printf("  -p N                       producer threads (default 2)\n");
+    printf("  -c N                       consumer threads (default 2)\n");
+    printf("  -d SECONDS                 run duration (default 2)\n");
+    printf("  -n N                       queue capacity (default %d)\n", DEFAULT_CAPACITY);
+    printf("  --csv                      print percentile distributions as CSV\n");
+}
+
+int main(int argc, char* argv[]) {
+    LoadConfig cfg = {&g_queues[0], 100000.0, ARRIVAL_POISSON, 32, 2, 2, 2.0,
+                      DEFAULT_CAPACITY, 0};
+    static struct option long_options[] = {
+        {"csv", no_argument, NULL, 'C'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "q:r:a:b:p:c:d:n:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'q':
+                cfg.ops = NULL;
+                for (size_t i = 0; i < sizeof(g_queues) / sizeof(g_queues[0]); i++) {
+                    if (strcmp(optarg, g_queues[i].name) == 0) {
+                        cfg.ops = &g_queues[i];
+                    }
+                }
+                if (cfg.ops == NULL) {
+                    fprintf(stderr, "Error: unknown queue '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'r':
+                cfg.rate = atof(optarg);
+                break;
+            case 'a':
+                if (strcmp(optarg, "uniform") == 0) {
+                    cfg.arrival = ARRIVAL_UNIFORM;
+                } else if (strcmp(optarg, "poisson") == 0) {
+                    cfg.arrival = ARRIVAL_POISSON;
+                } else if (strcmp(optarg, "bursty") == 0) {
+                    cfg.arrival = ARRIVAL_BURSTY;
+                } else {
+                    fprintf(stderr, "Error: unknown arrival process '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'b':
+                cfg.burst = atoi(optarg);
+                break;
+            case 'p':
+                cfg.producers = atoi(optarg);
+                break;
+            case 'c':
+                cfg.consumers = atoi(optarg);
+                break;
+            case 'd':
+                cfg.duration = atof(optarg);
+                break;
+            case 'n':
+                cfg.capacity = (size_t)atol(optarg);
+                break;
+            case 'C':
+                cfg.csv = 1;
+                break;
+            case 'h':
+                printUsage(argv[0]);
+                return 0;
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (cfg.rate <= 0 || cfg.burst < 1 || cfg.duration <= 0 || cfg.capacity < 1 ||
+        cfg.producers < 1 || cfg.producers > MAX_PRODUCERS ||
+        cfg.consumers < 1 || cfg.consumers > MAX_CONSUMERS) {
+        fprintf(stderr, "Error: invalid configuration\n");
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    return runLoad(&cfg);
+}
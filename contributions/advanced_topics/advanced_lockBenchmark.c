@@ -0,0 +1,579 @@
+/*
+ * Advanced Topic: Thread Synchronization Microbenchmarks
+ * Author: gpl-gowthamchand
+ * Date: 2026-10-18
+ *
+ * Description: Measures the uncontended and contended cost of common locking
+ * primitives and the latency of waking another thread, and prints the results
+ * as CSV so a primitive can be chosen per workload based on data
+ *
+ * Prerequisites: advanced_threading.c, C11 atomics, basic cache-coherence knowledge
+ *
+ * Technical Details:
+ * - pthread_mutex_t as the baseline
+ * - TTAS (test-and-test-and-set) spinlock
+ * - Ticket lock (FIFO fair spinlock)
+ * - MCS queue lock (each waiter spins on its own cache line)
+ * - Raw futex lock (Drepper's three-state mutex, Linux only)
+ * - Handoff latency: a token passed around a ring of threads using
+ *   pthread condition variables or raw futex wait/wake
+ *
+ * Implementation Notes:
+ * Every lock benchmark runs 1..N threads, each pinned to CPU (id % ncpus).
+ * All threads wait on a start barrier, then perform ITERATIONS lock/increment/
+ * unlock rounds on a shared counter. The threads=1 row is the uncontended cost.
+ * The final counter is compared with threads * iterations, so every row is
+ * also a race-condition test of the primitive (see the "ok" column).
+ *
+ * Performance Characteristics:
+ * - Time Complexity: O(threads * iterations) per row
+ * - Space Complexity: O(threads)
+ * - Memory Usage: one cache line per lock and per MCS node
+ *
+ * Dependencies:
+ * - pthread library (-pthread flag required for compilation)
+ * - C11 <stdatomic.h>
+ * - Linux for futex rows and CPU pinning (skipped elsewhere)
+ *
+ * Testing:
+ * - gcc -O2 -pthread advanced_lockBenchmark.c -o lockBenchmark
+ * - ./lockBenchmark [max_threads] [iterations] > locks.csv
+ *
+ * Known Limitations:
+ * - Spinlocks yield the CPU after a bounded spin so oversubscribed runs
+ *   (threads > cores) still finish; numbers for those rows are pessimistic
+ * - Wall-clock timing includes thread start skew of a few microseconds
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#define CACHE_LINE 64
+#define MAX_BENCH_THREADS 64
+#define DEFAULT_ITERATIONS 200000
+#define DEFAULT_HANDOFFS 20000
+#define SPINS_BEFORE_YIELD 128
+
+// Relax the core while spinning (pause on x86, yield on ARM)
+static inline void cpuRelax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ __volatile__("pause");
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// Spin politely and give the CPU away if the owner is not running
+static inline void spinWait(int* spins) {
+    if (++(*spins) < SPINS_BEFORE_YIELD) {
+        cpuRelax();
+    } else {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+// Monotonic clock in nanoseconds
+static uint64_t nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Per-thread timestamps; workers stamp their own times so a descheduled
+// main thread cannot skew the measurement
+typedef struct {
+    uint64_t start_ns;
+    uint64_t end_ns;
+} WorkerClock;
+
+// Wall time from the first worker starting to the last one finishing
+static uint64_t spanNs(const WorkerClock* clocks, int count) {
+    uint64_t first = UINT64_MAX, last = 0;
+    for (int i = 0; i < count; i++) {
+        if (clocks[i].start_ns < first) {
+            first = clocks[i].start_ns;
+        }
+        if (clocks[i].end_ns > last) {
+            last = clocks[i].end_ns;
+        }
+    }
+    return last > first ? last - first : 1;
+}
+
+// Pin the calling thread to one CPU (no-op where unsupported)
+static void pinToCpu(int cpu) {
+#ifdef __linux__
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpus < 1) {
+        ncpus = 1;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % ncpus, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+#ifdef __linux__
+static long futexWait(atomic_int* addr, int expected) {
+    return syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static long futexWake(atomic_int* addr, int count) {
+    return syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Lock implementations
+// ---------------------------------------------------------------------------
+
+// TTAS spinlock: read until free, then try to grab it with one exchange
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_int locked;
+} TtasLock;
+
+static void ttasInit(TtasLock* lock) {
+    atomic_init(&lock->locked, 0);
+}
+
+static void ttasLock(TtasLock* lock) {
+    int spins = 0;
+    for (;;) {
+        if (!atomic_exchange_explicit(&lock->locked, 1, memory_order_acquire)) {
+            return;
+        }
+        while (atomic_load_explicit(&lock->locked, memory_order_relaxed)) {
+            spinWait(&spins);
+        }
+    }
+}
+
+static void ttasUnlock(TtasLock* lock) {
+    atomic_store_explicit(&lock->locked, 0, memory_order_release);
+}
+
+// Ticket lock: take a number, wait until it is served
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_uint next;
+    atomic_uint serving;
+} TicketLock;
+
+static void ticketInit(TicketLock* lock) {
+    atomic_init(&lock->next, 0);
+    atomic_init(&lock->serving, 0);
+}
+
+static void ticketLock(TicketLock* lock) {
+    unsigned int ticket = atomic_fetch_add_explicit(&lock->next, 1, memory_order_relaxed);
+    int spins = 0;
+    while (atomic_load_explicit(&lock->serving, memory_order_acquire) != ticket) {
+        spinWait(&spins);
+    }
+}
+
+static void ticketUnlock(TicketLock* lock) {
+    unsigned int current = atomic_load_explicit(&lock->serving, memory_order_relaxed);
+    atomic_store_explicit(&lock->serving, current + 1, memory_order_release);
+}
+
+// MCS lock: waiters form a queue and each spins on its own node
+typedef struct McsNode {
+    _Alignas(CACHE_LINE) struct McsNode* _Atomic next;
+    atomic_int waiting;
+} McsNode;
+
+typedef struct {
+    _Alignas(CACHE_LINE) McsNode* _Atomic tail;
+} McsLock;
+
+static void mcsInit(McsLock* lock) {
+    atomic_init(&lock->tail, NULL);
+}
+
+static void mcsLock(McsLock* lock, McsNode* node) {
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+    atomic_store_explicit(&node->waiting, 1, memory_order_relaxed);
+
+    McsNode* prev = atomic_exchange_explicit(&lock->tail, node, memory_order_acq_rel);
+    if (prev == NULL) {
+        return; // Lock was free
+    }
+
+    atomic_store_explicit(&prev->next, node, memory_order_release);
+    int spins = 0;
+    while (atomic_load_explicit(&node->waiting, memory_order_acquire)) {
+        spinWait(&spins);
+    }
+}
+
+static void mcsUnlock(McsLock* lock, McsNode* node) {
+    McsNode* next = atomic_load_explicit(&node->next, memory_order_acquire);
+    if (next == NULL) {
+        McsNode* expected = node;
+        if (atomic_compare_exchange_strong_explicit(&lock->tail, &expected, NULL,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire)) {
+            return; // No successor
+        }
+        // A successor is linking itself in; wait for it
+        int spins = 0;
+        while ((next = atomic_load_explicit(&node->next, memory_order_acquire)) == NULL) {
+            spinWait(&spins);
+        }
+    }
+    atomic_store_explicit(&next->waiting, 0, memory_order_release);
+}
+
+#ifdef __linux__
+// Futex lock: 0 = free, 1 = locked, 2 = locked with waiters
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_int state;
+} FutexLock;
+
+static void futexLockInit(FutexLock* lock) {
+    atomic_init(&lock->state, 0);
+}
+
+static void futexLock(FutexLock* lock) {
+    int c = 0;
+    if (atomic_compare_exchange_strong(&lock->state, &c, 1)) {
+        return; // Fast path, no syscall
+    }
+    if (c != 2) {
+        c = atomic_exchange(&lock->state, 2);
+    }
+    while (c != 0) {
+        futexWait(&lock->state, 2);
+        c = atomic_exchange(&lock->state, 2);
+    }
+}
+
+static void futexUnlock(FutexLock* lock) {
+    if (atomic_fetch_sub(&lock->state, 1) != 1) {
+        atomic_store(&lock->state, 0);
+        futexWake(&lock->state, 1);
+    }
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Lock benchmark driver
+// ---------------------------------------------------------------------------
+
+typedef enum {
+    LOCK_MUTEX,
+    LOCK_TTAS,
+    LOCK_TICKET,
+    LOCK_MCS,
+    LOCK_FUTEX,
+    LOCK_KIND_COUNT
+} LockKind;
+
+static const char* g_lock_names[LOCK_KIND_COUNT] = {
+    "pthread_mutex", "ttas_spinlock", "ticket_lock", "mcs_lock", "futex_lock"
+};
+
+typedef struct {
+    LockKind kind;
+    pthread_mutex_t mutex;
+    TtasLock ttas;
+    TicketLock ticket;
+    McsLock mcs;
+#ifdef __linux__
+    FutexLock futex;
+#endif
+    _Alignas(CACHE_LINE) long counter;
+    long iterations;
+    pthread_barrier_t start;
+} LockBench;
+
+typedef struct {
+    LockBench* bench;
+    int id;
+    WorkerClock clock;
+    McsNode node;
+} LockWorker;
+
+static void* lockWorker(void* arg) {
+    LockWorker* worker = (LockWorker*)arg;
+    LockBench* bench = worker->bench;
+
+    pinToCpu(worker->id);
+    pthread_barrier_wait(&bench->start);
+    worker->clock.start_ns = nowNs();
+
+    for (long i = 0; i < bench->iterations; i++) {
+        switch (bench->kind) {
+            case LOCK_MUTEX:
+                pthread_mutex_lock(&bench->mutex);
+                bench->counter++;
+                pthread_mutex_unlock(&bench->mutex);
+                break;
+            case LOCK_TTAS:
+                ttasLock(&bench->ttas);
+                bench->counter++;
+                ttasUnlock(&bench->ttas);
+                break;
+            case LOCK_TICKET:
+                ticketLock(&bench->ticket);
+                bench->counter++;
+                ticketUnlock(&bench->ticket);
+                break;
+            case LOCK_MCS:
+                mcsLock(&bench->mcs, &worker->node);
+                bench->counter++;
+                mcsUnlock(&bench->mcs, &worker->node);
+                break;
+            case LOCK_FUTEX:
+#ifdef __linux__
+                futexLock(&bench->futex);
+                bench->counter++;
+                futexUnlock(&bench->futex);
+#endif
+                break;
+            default:
+                break;
+        }
+    }
+    worker->clock.end_ns = nowNs();
+    return NULL;
+}
+
+// Run one (lock, threads) configuration and print a CSV row
+static void runLockBenchmark(LockKind kind, int threads, long iterations) {
+    LockBench* bench = aligned_alloc(CACHE_LINE, (sizeof(LockBench) + CACHE_LINE - 1)
+                                                 / CACHE_LINE * CACHE_LINE);
+    LockWorker* workers = aligned_alloc(CACHE_LINE, (sizeof(LockWorker) * threads + CACHE_LINE - 1)
+                                                    / CACHE_LINE * CACHE_LINE);
+    pthread_t tids[MAX_BENCH_THREADS];
+
+    if (bench == NULL || workers == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+
+    memset(bench, 0, sizeof(*bench));
+    bench->kind = kind;
+    bench->iterations = iterations;
+    pthread_mutex_init(&bench->mutex, NULL);
+    ttasInit(&bench->ttas);
+    ticketInit(&bench->ticket);
+    mcsInit(&bench->mcs);
+#ifdef __linux__
+    futexLockInit(&bench->futex);
+#endif
+    pthread_barrier_init(&bench->start, NULL, threads);
+
+    for (int i = 0; i < threads; i++) {
+        workers[i].bench = bench;
+        workers[i].id = i;
+        if (pthread_create(&tids[i], NULL, lockWorker, &workers[i]) != 0) {
+            fprintf(stderr, "Error creating thread %d\n", i);
+            exit(1);
+        }
+    }
+
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    WorkerClock clocks[MAX_BENCH_THREADS];
+    for (int i = 0; i < threads; i++) {
+        clocks[i] = workers[i].clock;
+    }
+    uint64_t elapsed = spanNs(clocks, threads);
+
+    long total_ops = iterations * threads;
+    int ok = bench->counter == total_ops;
+    printf("lock,%s,%d,%ld,%llu,%.2f,%.0f,%s\n",
+           g_lock_names[kind], threads, total_ops,
+           (unsigned long long)elapsed,
+           (double)elapsed / (double)total_ops,
+           (double)total_ops * 1e9 / (double)elapsed,
+           ok ? "ok" : "RACE");
+    fflush(stdout);
+
+    pthread_barrier_destroy(&bench->start);
+    pthread_mutex_destroy(&bench->mutex);
+    free(workers);
+    free(bench);
+}
+
+// ---------------------------------------------------------------------------
+// Handoff (ping-pong) latency: a token travels around a ring of threads
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    int use_futex;
+    int threads;
+    long handoffs;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    _Alignas(CACHE_LINE) atomic_int turn; // Index of the thread holding the token
+    atomic_long passed;
+    pthread_barrier_t start;
+} HandoffBench;
+
+typedef struct {
+    HandoffBench* bench;
+    int id;
+    WorkerClock clock;
+} HandoffWorker;
+
+static void* handoffWorker(void* arg) {
+    HandoffWorker* worker = (HandoffWorker*)arg;
+    HandoffBench* bench = worker->bench;
+    int next = (worker->id + 1) % bench->threads;
+
+    pinToCpu(worker->id);
+    pthread_barrier_wait(&bench->start);
+    worker->clock.start_ns = nowNs();
+
+    for (;;) {
+        // Wait for the token
+        if (bench->use_futex) {
+#ifdef __linux__
+            int t;
+            while ((t = atomic_load(&bench->turn)) != worker->id) {
+                if (t < 0) {
+                    worker->clock.end_ns = nowNs();
+                    return NULL;
+                }
+                futexWait(&bench->turn, t);
+            }
+#endif
+        } else {
+            pthread_mutex_lock(&bench->mutex);
+            while (atomic_load(&bench->turn) != worker->id && atomic_load(&bench->turn) >= 0) {
+                pthread_cond_wait(&bench->cond, &bench->mutex);
+            }
+            pthread_mutex_unlock(&bench->mutex);
+            if (atomic_load(&bench->turn) < 0) {
+                worker->clock.end_ns = nowNs();
+                return NULL;
+            }
+        }
+
+        // Pass it on (or stop everybody once enough handoffs happened)
+        int target = atomic_fetch_add(&bench->passed, 1) + 1 >= bench->handoffs ? -1 : next;
+        if (bench->use_futex) {
+#ifdef __linux__
+            atomic_store(&bench->turn, target);
+            futexWake(&bench->turn, bench->threads); // Every ring member waits on one word
+#endif
+        } else {
+            pthread_mutex_lock(&bench->mutex);
+            atomic_store(&bench->turn, target);
+            pthread_cond_broadcast(&bench->cond);
+            pthread_mutex_unlock(&bench->mutex);
+        }
+        if (target < 0) {
+            worker->clock.end_ns = nowNs();
+            return NULL;
+        }
+    }
+}
+
+static void runHandoffBenchmark(int use_futex, int threads, long handoffs) {
+    HandoffBench bench;
+    HandoffWorker workers[MAX_BENCH_THREADS];
+    pthread_t tids[MAX_BENCH_THREADS];
+
+    memset(&bench, 0, sizeof(bench));
+    bench.use_futex = use_futex;
+    bench.threads = threads;
+    bench.handoffs = handoffs;
+    pthread_mutex_init(&bench.mutex, NULL);
+    pthread_cond_init(&bench.cond, NULL);
+    atomic_init(&bench.turn, 0);
+    atomic_init(&bench.passed, 0);
+    pthread_barrier_init(&bench.start, NULL, threads);
+
+    for (int i = 0; i < threads; i++) {
+        workers[i].bench = &bench;
+        workers[i].id = i;
+        if (pthread_create(&tids[i], NULL, handoffWorker, &workers[i]) != 0) {
+            fprintf(stderr, "Error creating thread %d\n", i);
+            exit(1);
+        }
+    }
+
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    WorkerClock clocks[MAX_BENCH_THREADS];
+    for (int i = 0; i < threads; i++) {
+        clocks[i] = workers[i].clock;
+    }
+    uint64_t elapsed = spanNs(clocks, threads);
+
+    long passed = atomic_load(&bench.passed);
+    printf("handoff,%s,%d,%ld,%llu,%.2f,%.0f,%s\n",
+           use_futex ? "futex_pingpong" : "condvar_pingpong", threads, passed,
+           (unsigned long long)elapsed,
+           (double)elapsed / (double)passed,
+           (double)passed * 1e9 / (double)elapsed,
+           passed == handoffs ? "ok" : "LOST");
+    fflush(stdout);
+
+    pthread_barrier_destroy(&bench.start);
+    pthread_cond_destroy(&bench.cond);
+    pthread_mutex_destroy(&bench.mutex);
+}
+
+int main(int argc, char* argv[]) {
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = (argc > 1) ? atoi(argv[1]) : (int)(ncpus > 0 ? ncpus : 1);
+    long iterations = (argc > 2) ? atol(argv[2]) : DEFAULT_ITERATIONS;
+
+    if (max_threads < 1 || max_threads > MAX_BENCH_THREADS || iterations < 1) {
+        fprintf(stderr, "Usage: %s [max_threads 1-%d] [iterations]\n",
+                argv[0], MAX_BENCH_THREADS);
+        return 1;
+    }
+
+    fprintf(stderr, "Benchmarking 1..%d threads, %ld iterations per thread (%ld CPUs online)\n",
+            max_threads, iterations, ncpus);
+
+    // CSV header: ns_per_op is per lock/unlock pair or per token handoff
+    printf("benchmark,primitive,threads,ops,total_ns,ns_per_op,ops_per_sec,check\n");
+
+    for (int kind = 0; kind < LOCK_KIND_COUNT; kind++) {
+#ifndef __linux__
+        if (kind == LOCK_FUTEX) {
+            continue;
+        }
+#endif
+        for (int t = 1; t <= max_threads; t++) {
+            runLockBenchmark((LockKind)kind, t, iterations);
+        }
+    }
+
+    // A handoff needs at least two threads to pass the token between
+    long handoffs = iterations < DEFAULT_HANDOFFS ? iterations : DEFAULT_HANDOFFS;
+    int ring_max = max_threads < 2 ? 2 : max_threads;
+    for (int t = 2; t <= ring_max; t++) {
+        runHandoffBenchmark(0, t, handoffs);
+#ifdef __linux__
+        runHandoffBenchmark(1, t, handoffs);
+#endif
+    }
+
+    return 0;
+}
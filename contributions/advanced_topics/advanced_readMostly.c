@@ -0,0 +1,594 @@
+/*
+ * Advanced Topic: Read-Mostly Shared State (Seqlock and RCU)
+ * Author: gpl-gowthamchand
+ * Date: 2026-10-18
+ *
+ * Description: Two reader-friendly synchronization schemes for shared data that
+ * is read far more often than it is written, demonstrated on a counter and a
+ * shared configuration struct, and benchmarked against pthread_rwlock_t and
+ * the plain mutex used by getCounterValue() in advanced_threading.c
+ *
+ * Prerequisites: advanced_threading.c, C11 atomics and memory ordering
+ *
+ * Technical Details:
+ * - Seqlock: writers bump a sequence number to odd, write, bump to even;
+ *   readers copy optimistically and retry if the sequence changed or was odd.
+ *   Readers never write shared memory, so they never block writers.
+ * - RCU-style pointer swap: readers dereference a shared pointer inside a
+ *   read-side section; writers publish a modified copy with one atomic
+ *   exchange and free the old copy after an epoch-based grace period.
+ * - Epoch grace periods: each reader thread announces the global epoch it
+ *   entered with (0 = outside any read section). A writer advances the epoch
+ *   and waits until no reader is still inside an older epoch.
+ *
+ * Implementation Notes:
+ * Seqlock-protected data is stored as _Atomic 64-bit words and copied with
+ * relaxed loads, so a torn read is a detected retry rather than a data race.
+ * Every snapshot carries a checksum field; the benchmark counts snapshots that
+ * fail the check ("torn"), which must stay 0 for every primitive.
+ *
+ * Performance Characteristics:
+ * - Seqlock read: two loads of the sequence + the copy, retry on conflict
+ * - RCU read: two stores to a thread-local slot + one pointer load
+ * - Writes: O(data size) copy; RCU writers also wait one grace period
+ *
+ * Dependencies:
+ * - pthread library (-pthread flag required for compilation)
+ * - C11 <stdatomic.h>
+ *
+ * Testing:
+ * - gcc -O2 -pthread advanced_readMostly.c -o readMostly
+ * - ./readMostly                 (demo + benchmark at 99:1 read:write)
+ * - ./readMostly 8 500000 999    (8 threads, 500K ops each, 99.9% reads)
+ *
+ * Known Limitations:
+ * - RCU readers must register a slot (MAX_READERS) before reading
+ * - Seqlock writers spin readers under heavy write load (not for write-heavy data)
+ * - RCU writers block for a grace period; batch updates where possible
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define CACHE_LINE 64
+#define MAX_READERS 64
+#define DEFAULT_THREADS 4
+#define DEFAULT_OPS 200000
+#define DEFAULT_READ_PER_MILLE 990  // 99:1 read:write
+
+static uint64_t nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+// Shared data used by every scheme
+// ---------------------------------------------------------------------------
+
+// Shared configuration; checksum ties the fields together so torn reads show up
+typedef struct {
+    uint64_t version;
+    int64_t max_connections;
+    int64_t timeout_ms;
+    double sample_rate;
+    char name[32];
+    uint64_t checksum;
+} SharedConfig;
+
+// Counter snapshot: value plus the time of the last update
+typedef struct {
+    int64_t value;
+    uint64_t updated_ns;
+} CounterSnapshot;
+
+static uint64_t configChecksum(const SharedConfig* c) {
+    uint64_t h = c->version * 0x9E3779B97F4A7C15ull;
+    h ^= (uint64_t)c->max_connections + (h << 6) + (h >> 2);
+    h ^= (uint64_t)c->timeout_ms + (h << 6) + (h >> 2);
+    uint64_t bits;
+    memcpy(&bits, &c->sample_rate, sizeof(bits));
+    h ^= bits + (h << 6) + (h >> 2);
+    for (size_t i = 0; i < sizeof(c->name); i++) {
+        h ^= (uint64_t)(unsigned char)c->name[i] + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+// Derive a new configuration from the previous one
+static void configNext(SharedConfig* c) {
+    c->version++;
+    c->max_connections = 100 + (int64_t)(c->version % 900);
+    c->timeout_ms = 1000 + (int64_t)(c->version % 30) * 100;
+    c->sample_rate = (double)(c->version % 100) / 100.0;
+    snprintf(c->name, sizeof(c->name), "config-v%llu", (unsigned long long)c->version);
+    c->checksum = configChecksum(c);
+}
+
+static int configValid(const SharedConfig* c) {
+    return c->checksum == configChecksum(c);
+}
+
+// ---------------------------------------------------------------------------
+// Seqlock
+// ---------------------------------------------------------------------------
+
+#define CONFIG_WORDS ((sizeof(SharedConfig) + 7) / 8)
+
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_uint sequence;
+    pthread_mutex_t writer;                  // Serializes writers only
+    _Atomic uint64_t words[CONFIG_WORDS];   // Payload as relaxed-atomic words
+} SeqlockConfig;
+
+static void seqlockInit(SeqlockConfig* s, const SharedConfig* initial) {
+    uint64_t words[CONFIG_WORDS] = {0};
+    atomic_init(&s->sequence, 0);
+    pthread_mutex_init(&s->writer, NULL);
+    memcpy(words, initial, sizeof(*initial));
+    for (size_t i = 0; i < CONFIG_WORDS; i++) {
+        atomic_init(&s->words[i], words[i]);
+    }
+}
+
+static void seqlockRead(SeqlockConfig* s, SharedConfig* out) {
+    uint64_t words[CONFIG_WORDS];
+    unsigned int before, after;
+    do {
+        before = atomic_load_explicit(&s->sequence, memory_order_acquire);
+        if (before & 1) {
+            sched_yield(); // Writer in progress
+            continue;
+        }
+        for (size_t i = 0; i < CONFIG_WORDS; i++) {
+            words[i] = atomic_load_explicit(&s->words[i], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&s->sequence, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    memcpy(out, words, sizeof(*out));
+}
+
+// Apply update() to the current value under the seqlock
+static void seqlockUpdate(SeqlockConfig* s, void (*update)(SharedConfig*)) {
+    uint64_t words[CONFIG_WORDS] = {0};
+    SharedConfig current;
+
+    pthread_mutex_lock(&s->writer);
+    for (size_t i = 0; i < CONFIG_WORDS; i++) {
+        words[i] = atomic_load_explicit(&s->words[i], memory_order_relaxed);
+    }
+    memcpy(&current, words, sizeof(current));
+    update(&current);
+    memcpy(words, &current, sizeof(current));
+
+    unsigned int seq = atomic_load_explicit(&s->sequence, memory_order_relaxed);
+    atomic_store_explicit(&s->sequence, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (size_t i = 0; i < CONFIG_WORDS; i++) {
+        atomic_store_explicit(&s->words[i], words[i], memory_order_relaxed);
+    }
+    atomic_store_explicit(&s->sequence, seq + 2, memory_order_release);
+    pthread_mutex_unlock(&s->writer);
+}
+
+// ---------------------------------------------------------------------------
+// RCU-style pointer swap with epoch-based grace periods
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_ulong epoch;    // Epoch entered, 0 = quiescent
+} ReaderSlot;
+
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic(void*) current;
+    _Alignas(CACHE_LINE) atomic_ulong global_epoch;
+    pthread_mutex_t writer;
+    ReaderSlot readers[MAX_READERS];
+    atomic_int reader_count;
+} RcuDomain;
+
+static void rcuInit(RcuDomain* d, void* initial) {
+    atomic_init(&d->current, initial);
+    atomic_init(&d->global_epoch, 1);
+    pthread_mutex_init(&d->writer, NULL);
+    for (int i = 0; i < MAX_READERS; i++) {
+        atomic_init(&d->readers[i].epoch, 0);
+    }
+    atomic_init(&d->reader_count, 0);
+}
+
+// Returns the slot index for a reader thread, or -1 if the domain is full
+static int rcuRegisterReader(RcuDomain* d) {
+    int slot = atomic_fetch_add(&d->reader_count, 1);
+    return slot < MAX_READERS ? slot : -1;
+}
+
+// Enter a read-side section and return the current object.
+// Announcing the epoch must be ordered before loading the pointer (seq_cst).
+static void* rcuReadLock(RcuDomain* d, int slot) {
+    atomic_store(&d->readers[slot].epoch, atomic_load(&d->global_epoch));
+    return atomic_load(&d->current);
+}
+
+static void rcuReadUnlock(RcuDomain* d, int slot) {
+    atomic_store_explicit(&d->readers[slot].epoch, 0, memory_order_release);
+}
+
+// Wait until every reader that might still see the old pointer has left
+static void rcuSynchronize(RcuDomain* d) {
+    unsigned long target = atomic_fetch_add(&d->global_epoch, 1) + 1;
+    int count = atomic_load(&d->reader_count);
+    if (count > MAX_READERS) {
+        count = MAX_READERS;
+    }
+    for (int i = 0; i < count; i++) {
+        for (;;) {
+            unsigned long e = atomic_load(&d->readers[i].epoch);
+            if (e == 0 || e >= target) {
+                break;
+            }
+            sched_yield();
+        }
+    }
+}
+
+// Publish a new object and free the old one after a grace period
+static void rcuReplace(RcuDomain* d, void* replacement) {
+    void* old = atomic_exchange(&d->current, replacement);
+    rcuSynchronize(d);
+    free(old);
+}
+
+// Copy-update: writers are serialized, readers are never blocked
+static void rcuUpdateConfig(RcuDomain* d, void (*update)(SharedConfig*)) {
+    pthread_mutex_lock(&d->writer);
+    SharedConfig* next = malloc(sizeof(SharedConfig));
+    if (next == NULL) {
+        pthread_mutex_unlock(&d->writer);
+        fprintf(stderr, "Error: out of memory\n");
+        return;
+    }
+    *next = *(SharedConfig*)atomic_load(&d->current);
+    update(next);
+    rcuReplace(d, next);
+    pthread_mutex_unlock(&d->writer);
+}
+
+// ---------------------------------------------------------------------------
+// Demo: counter and configuration
+// ---------------------------------------------------------------------------
+
+static void demonstrateSeqlockCounter(void) {
+    printf("=== Seqlock Counter Demo ===\n");
+
+    // Value and timestamp must be read as a consistent pair
+    struct {
+        _Alignas(CACHE_LINE) atomic_uint sequence;
+        _Atomic int64_t value;
+        _Atomic uint64_t updated_ns;
+    } counter;
+    atomic_init(&counter.sequence, 0);
+    atomic_init(&counter.value, 0);
+    atomic_init(&counter.updated_ns, nowNs());
+
+    for (int i = 0; i < 5; i++) {
+        // Writer (single writer here, so no writer mutex needed)
+        unsigned int seq = atomic_load_explicit(&counter.sequence, memory_order_relaxed);
+        atomic_store_explicit(&counter.sequence, seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        atomic_store_explicit(&counter.value, atomic_load_explicit(&counter.value, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+        atomic_store_explicit(&counter.updated_ns, nowNs(), memory_order_relaxed);
+        atomic_store_explicit(&counter.sequence, seq + 2, memory_order_release);
+
+        // Reader
+        CounterSnapshot snap;
+        unsigned int before, after;
+        do {
+            before = atomic_load_explicit(&counter.sequence, memory_order_acquire);
+            snap.value = atomic_load_explicit(&counter.value, memory_order_relaxed);
+            snap.updated_ns = atomic_load_explicit(&counter.updated_ns, memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            after = atomic_load_explicit(&counter.sequence, memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        printf("Counter = %lld (sequence %u, updated at %llu ns)\n",
+               (long long)snap.value, after, (unsigned long long)snap.updated_ns);
+    }
+}
+
+static void bumpCounter(CounterSnapshot* c) {
+    c->value++;
+    c->updated_ns = nowNs();
+}
+
+static void demonstrateRcuCounter(void) {
+    printf("\n=== RCU Counter Demo ===\n");
+
+    RcuDomain domain;
+    CounterSnapshot* initial = calloc(1, sizeof(CounterSnapshot));
+    if (initial == NULL) {
+        printf("Memory allocation failed!\n");
+        return;
+    }
+    rcuInit(&domain, initial);
+    int slot = rcuRegisterReader(&domain);
+
+    for (int i = 0; i < 5; i++) {
+        // Writer: copy, modify, publish, reclaim after grace period
+        CounterSnapshot* next = malloc(sizeof(CounterSnapshot));
+        if (next == NULL) {
+            printf("Memory allocation failed!\n");
+            break;
+        }
+        *next = *(CounterSnapshot*)atomic_load(&domain.current);
+        bumpCounter(next);
+        rcuReplace(&domain, next);
+
+        // Reader
+        CounterSnapshot* snap = rcuReadLock(&domain, slot);
+        printf("Counter = %lld (epoch %lu)\n", (long long)snap->value,
+               atomic_load(&domain.global_epoch));
+        rcuReadUnlock(&domain, slot);
+    }
+
+    free(atomic_load(&domain.current));
+    pthread_mutex_destroy(&domain.writer);
+}
+
+static void demonstrateConfig(void) {
+    printf("\n=== Shared Config Demo ===\n");
+
+    SharedConfig initial = {0};
+    configNext(&initial);
+
+    SeqlockConfig seqlock;
+    seqlockInit(&seqlock, &initial);
+    seqlockUpdate(&seqlock, configNext);
+
+    SharedConfig copy;
+    seqlockRead(&seqlock, &copy);
+    printf("Seqlock: %s max_connections=%lld timeout=%lldms sample_rate=%.2f valid=%s\n",
+           copy.name, (long long)copy.max_connections, (long long)copy.timeout_ms,
+           copy.sample_rate, configValid(&copy) ? "yes" : "NO");
+
+    RcuDomain domain;
+    SharedConfig* first = malloc(sizeof(SharedConfig));
+    if (first == NULL) {
+        printf("Memory allocation failed!\n");
+        return;
+    }
+    *first = initial;
+    rcuInit(&domain, first);
+    int slot = rcuRegisterReader(&domain);
+    rcuUpdateConfig(&domain, configNext);
+    rcuUpdateConfig(&domain, configNext);
+
+    const SharedConfig* live = rcuReadLock(&domain, slot);
+    printf("RCU:     %s max_connections=%lld timeout=%lldms sample_rate=%.2f valid=%s\n",
+           live->name, (long long)live->max_connections, (long long)live->timeout_ms,
+           live->sample_rate, configValid(live) ? "yes" : "NO");
+    rcuReadUnlock(&domain, slot);
+
+    free(atomic_load(&domain.current));
+    pthread_mutex_destroy(&domain.writer);
+    pthread_mutex_destroy(&seqlock.writer);
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark: mutex vs rwlock vs seqlock vs RCU on the shared config
+// ---------------------------------------------------------------------------
+
+typedef enum {
+    SCHEME_MUTEX,
+    SCHEME_RWLOCK,
+    SCHEME_SEQLOCK,
+    SCHEME_RCU,
+    SCHEME_COUNT
+} Scheme;
+
+static const char* g_scheme_names[SCHEME_COUNT] = {"mutex", "rwlock", "seqlock", "rcu"};
+
+typedef struct {
+    Scheme scheme;
+    long ops;
+    int read_per_mille;
+    pthread_barrier_t start;
+    // Mutex and rwlock share one plain struct
+    pthread_mutex_t mutex;
+    pthread_rwlock_t rwlock;
+    SharedConfig plain;
+    SeqlockConfig seqlock;
+    RcuDomain rcu;
+} ReadBench;
+
+typedef struct {
+    ReadBench* bench;
+    int id;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t torn;
+    uint64_t elapsed_ns;
+} ReadWorker;
+
+static void* readWorker(void* arg) {
+    ReadWorker* w = arg;
+    ReadBench* b = w->bench;
+    uint64_t rng = 0x2545F4914F6CDD1Dull * (uint64_t)(w->id + 1);
+    int slot = b->scheme == SCHEME_RCU ? rcuRegisterReader(&b->rcu) : -1;
+    SharedConfig copy;
+    volatile int64_t sink = 0;
+
+    if (b->scheme == SCHEME_RCU && slot < 0) {
+        fprintf(stderr, "Error: too many RCU readers\n");
+        return NULL;
+    }
+
+    pthread_barrier_wait(&b->start);
+    uint64_t begin = nowNs();
+
+    for (long i = 0; i < b->ops; i++) {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        int is_read = (int)(rng % 1000) < b->read_per_mille;
+
+        switch (b->scheme) {
+            case SCHEME_MUTEX:
+                pthread_mutex_lock(&b->mutex);
+                if (is_read) {
+                    copy = b->plain;
+                } else {
+                    configNext(&b->plain);
+                }
+                pthread_mutex_unlock(&b->mutex);
+                break;
+            case SCHEME_RWLOCK:
+                if (is_read) {
+                    pthread_rwlock_rdlock(&b->rwlock);
+                    copy = b->plain;
+                } else {
+                    pthread_rwlock_wrlock(&b->rwlock);
+                    configNext(&b->plain);
+                }
+                pthread_rwlock_unlock(&b->rwlock);
+                break;
+            case SCHEME_SEQLOCK:
+                if (is_read) {
+                    seqlockRead(&b->seqlock, &copy);
+                } else {
+                    seqlockUpdate(&b->seqlock, configNext);
+                }
+                break;
+            case SCHEME_RCU:
+                if (is_read) {
+                    const SharedConfig* live = rcuReadLock(&b->rcu, slot);
+                    copy = *live;
+                    rcuReadUnlock(&b->rcu, slot);
+                } else {
+                    rcuUpdateConfig(&b->rcu, configNext);
+                }
+                break;
+            default:
+                break;
+        }
+
+        if (is_read) {
+            w->reads++;
+            if (!configValid(&copy)) {
+                w->torn++;
+            }
+            sink += copy.max_connections;
+        } else {
+            w->writes++;
+        }
+    }
+
+    w->elapsed_ns = nowNs() - begin;
+    (void)sink;
+    return NULL;
+}
+
+static void runReadBenchmark(Scheme scheme, int threads, long ops, int read_per_mille) {
+    ReadBench* b = aligned_alloc(CACHE_LINE, (sizeof(ReadBench) + CACHE_LINE - 1)
+                                             / CACHE_LINE * CACHE_LINE);
+    ReadWorker workers[MAX_READERS];
+    pthread_t tids[MAX_READERS];
+
+    if (b == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    memset(b, 0, sizeof(*b));
+    b->scheme = scheme;
+    b->ops = ops;
+    b->read_per_mille = read_per_mille;
+    pthread_barrier_init(&b->start, NULL, threads);
+    pthread_mutex_init(&b->mutex, NULL);
+    pthread_rwlock_init(&b->rwlock, NULL);
+    configNext(&b->plain);
+    seqlockInit(&b->seqlock, &b->plain);
+    SharedConfig* first = malloc(sizeof(SharedConfig));
+    if (first == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    *first = b->plain;
+    rcuInit(&b->rcu, first);
+
+    for (int i = 0; i < threads; i++) {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].bench = b;
+        workers[i].id = i;
+        if (pthread_create(&tids[i], NULL, readWorker, &workers[i]) != 0) {
+            fprintf(stderr, "Error creating thread %d\n", i);
+            exit(1);
+        }
+    }
+
+    uint64_t reads = 0, writes = 0, torn = 0, slowest = 1;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        reads += workers[i].reads;
+        writes += workers[i].writes;
+        torn += workers[i].torn;
+        if (workers[i].elapsed_ns > slowest) {
+            slowest = workers[i].elapsed_ns;
+        }
+    }
+
+    uint64_t total = reads + writes;
+    printf("%s,%d,%.1f,%llu,%llu,%.2f,%.0f,%llu\n",
+           g_scheme_names[scheme], threads, read_per_mille / 10.0,
+           (unsigned long long)reads, (unsigned long long)writes,
+           (double)slowest * threads / (double)total,
+           (double)reads * 1e9 / (double)slowest,
+           (unsigned long long)torn);
+
+    free(atomic_load(&b->rcu.current));
+    pthread_mutex_destroy(&b->rcu.writer);
+    pthread_mutex_destroy(&b->seqlock.writer);
+    pthread_rwlock_destroy(&b->rwlock);
+    pthread_mutex_destroy(&b->mutex);
+    pthread_barrier_destroy(&b->start);
+    free(b);
+}
+
+int main(int argc, char* argv[]) {
+    int threads = (argc > 1) ? atoi(argv[1]) : DEFAULT_THREADS;
+    long ops = (argc > 2) ? atol(argv[2]) : DEFAULT_OPS;
+    int read_per_mille = (argc > 3) ? atoi(argv[3]) : DEFAULT_READ_PER_MILLE;
+
+    if (threads < 1 || threads > MAX_READERS || ops < 1 ||
+        read_per_mille < 0 || read_per_mille > 1000) {
+        fprintf(stderr, "Usage: %s [threads 1-%d] [ops_per_thread] [reads_per_1000_ops]\n",
+                argv[0], MAX_READERS);
+        return 1;
+    }
+
+    printf("========================================\n");
+    printf("    Read-Mostly Shared State in C       \n");
+    printf("========================================\n");
+
+    demonstrateSeqlockCounter();
+    demonstrateRcuCounter();
+    demonstrateConfig();
+
+    printf("\n=== Benchmark (%d threads, %ld ops each, %.1f%% reads) ===\n",
+           threads, ops, read_per_mille / 10.0);
+    // ns_per_op is thread-time per operation; torn must be 0
+    printf("scheme,threads,read_pct,reads,writes,ns_per_op,reads_per_sec,torn\n");
+    for (int s = 0; s < SCHEME_COUNT; s++) {
+        runReadBenchmark((Scheme)s, threads, ops, read_per_mille);
+    }
+
+    return 0;
+}
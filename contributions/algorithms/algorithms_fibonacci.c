@@ -0,0 +1,562 @@
+/*
+ * Algorithm: Fibonacci Numbers
+ * Author: gpl-gowthamchand
+ * Date: 2026-10-19
+ * Description: Several ways to compute F(n), from the exponential textbook
+ *              recursion to O(log n) fast doubling, with 64-bit, modular and
+ *              exact (bignum) results
+ *
+ * Time Complexity:
+ * - Recursive: O(phi^n) - every call makes two more
+ * - Iterative: O(n)
+ * - Fast doubling: O(log n) word operations; O(M(n)) for bignum results
+ * - Memoized: O(1) per repeated query after the table is filled
+ * Space Complexity: O(1), except the memo table and bignum results
+ *
+ * Features:
+ * - Fast doubling: F(2k) = F(k) (2 F(k+1) - F(k)), F(2k+1) = F(k)^2 + F(k+1)^2
+ * - 64-bit results are exact up to F(93) (the largest that fits) and are
+ *   F(n) mod 2^64 beyond it
+ * - F(n) mod m for any 64-bit m, for n up to 2^64 - 1
+ * - A memo table for many queries: exact values up to F(93), or values mod m
+ *   that stop growing at the Pisano period (F(n) mod m repeats with it)
+ * - Exact F(n) for large n with the Karatsuba routines of basic_bigNum.h,
+ *   using only two squarings per bit of n
+ *
+ * Usage: gcc -O2 -pthread algorithms_fibonacci.c -o fibonacci && ./fibonacci
+ *   ./fibonacci --mod N M            F(N) mod M
+ *   ./fibonacci --print N [THREADS]  every digit of F(N)
+ *   ./fibonacci --bench [N]          compare all methods (recursive one at N, default 32)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "../basic_programs/basic_bigNum.h"
+
+#define FIB_MAX_U64 93                      // F(93) < 2^64 < F(94)
+#define MEMO_MOD_LIMIT (1u << 20)           // Largest memo table kept for a modulus
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ---------------------------------------------------------------------------
+// 64-bit and modular kernels
+// ---------------------------------------------------------------------------
+
+// The textbook version (as in tutorial_functions.c): exponential in n
+int fibonacciRecursive(int n) {
+    if (n <= 1) {
+        return n;
+    }
+    return fibonacciRecursive(n - 1) + fibonacciRecursive(n - 2);
+}
+
+// O(n): walk the pairs (F(k), F(k+1)) up to k = n
+uint64_t fibonacciIterative(unsigned n) {
+    uint64_t a = 0, b = 1;
+    for (unsigned i = 0; i < n; i++) {
+        uint64_t next = a + b;
+        a = b;
+        b = next;
+    }
+    return a;
+}
+
+// O(log n): fast doubling over the bits of n, high bit first
+uint64_t fibonacciFastDoubling(uint64_t n) {
+    uint64_t a = 0, b = 1;                  // F(k), F(k+1), starting at k = 0
+    for (int bit = 63 - (n ? __builtin_clzll(n) : 63); bit >= 0; bit--) {
+        uint64_t even = a * (2 * b - a);    // F(2k)
+        uint64_t odd = a * a + b * b;       // F(2k + 1)
+        if ((n >> bit) & 1) {
+            a = odd;
+            b = even + odd;
+        } else {
+            a = even;
+            b = odd;
+        }
+    }
+    return a;
+}
+
+static uint64_t mulMod(uint64_t a, uint64_t b, uint64_t m) {
+    return (uint64_t)((unsigned __int128)a * b % m);
+}
+
+// F(n) mod m by fast doubling (m >= 1)
+uint64_t fibonacciMod(uint64_t n, uint64_t m) {
+    uint64_t a = 0, b = 1 % m;
+    for (int bit = 63 - (n ? __builtin_clzll(n) : 63); bit >= 0; bit--) {
+        uint64_t twice = b >= m - b ? b - (m - b) : b + b;
+        uint64_t even = mulMod(a, twice >= a ? twice - a : twice + (m - a), m);
+        uint64_t odd = mulMod(a, a, m);
+        uint64_t square = mulMod(b, b, m);
+        odd = odd >= m - square ? odd - (m - square) : odd + square;
+        if ((n >> bit) & 1) {
+            a = odd;
+            b = even >= m - odd ? even - (m - odd) : even + odd;
+        } else {
+            a = even;
+            b = odd;
+        }
+    }
+    return a;
+}
+
+// ---------------------------------------------------------------------------
+// Memo table for repeated queries
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint64_t modulus;                       // 0: exact 64-bit values
+    uint64_t* values;
+    size_t count;
+    size_t capacity;
+    size_t limit;                           // Most entries the table may hold
+    uint64_t period;                        // Pisano period once found, else 0
+} FibonacciMemo;
+
+// modulus 0 memoizes exact values (n <= 93); otherwise values mod modulus
+int initFibonacciMemo(FibonacciMemo* memo, uint64_t modulus) {
+    memo->modulus = modulus;
+    memo->limit = modulus == 0 ? FIB_MAX_U64 + 1 : MEMO_MOD_LIMIT;
+    memo->capacity = 64;
+    memo->values = malloc(memo->capacity * sizeof(uint64_t));
+    if (memo->values == NULL) {
+        return -1;
+    }
+    memo->values[0] = 0;
+    memo->values[1] = modulus == 1 ? 0 : 1;
+    memo->count = 2;
+    memo->period = modulus == 1 ? 1 : 0;
+    return 0;
+}
+
+void freeFibonacciMemo(FibonacciMemo* memo) {
+    free(memo->values);
+    memo->values = NULL;
+}
+
+// F(n) (mod the memo's modulus) into *out. Returns -1 if n is past F(93)
+// with no modulus, or out of memory.
+int fibonacciMemo(FibonacciMemo* memo, uint64_t n, uint64_t* out) {
+    if (memo->period != 0) {
+        n %= memo->period;
+    }
+    if (n < memo->count) {
+        *out = memo->values[n];
+        return 0;
+    }
+    if (n >= memo->limit && memo->modulus == 0) {
+        return -1;
+    }
+
+    // Extend the table up to n (or as far as it may grow, so a period that
+    // fits is found), watching for the period: F(p) = 0, F(p+1) = 1
+    uint64_t last = n < memo->limit ? n : memo->limit - 1;
+    while (memo->count <= last) {
+        if (memo->count == memo->capacity) {
+            size_t capacity = memo->capacity * 2 < memo->limit ? memo->capacity * 2 : memo->limit;
+            uint64_t* values = realloc(memo->values, capacity * sizeof(uint64_t));
+            if (values == NULL) {
+                return -1;
+            }
+            memo->values = values;
+            memo->capacity = capacity;
+        }
+        uint64_t a = memo->values[memo->count - 2], b = memo->values[memo->count - 1];
+        uint64_t next = a + b;
+        if (memo->modulus != 0 && (next >= memo->modulus || next < a)) {
+            next -= memo->modulus;
+        }
+        if (memo->modulus != 0 && b == 0 && next == 1) {
+            memo->period = memo->count - 1;
+            memo->count--;                  // Keep exactly one period
+            *out = memo->values[n % memo->period];
+            return 0;
+        }
+        memo->values[memo->count++] = next;
+    }
+    *out = n < memo->count ? memo->values[n] : fibonacciMod(n, memo->modulus);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Exact results
+// ---------------------------------------------------------------------------
+
+// Exact F(n) by adding limb arrays n times: O(n^2), for checking
+int fibonacciBigIterative(unsigned n, BigNum* out) {
+    size_t limbs = (size_t)(n * 0.6943 / 64) + 3;    // log2(phi) = 0.694...
+    uint64_t* a = calloc(limbs, sizeof(uint64_t));
+    uint64_t* b = calloc(limbs, sizeof(uint64_t));
+    if (a == NULL || b == NULL) {
+        free(a);
+        free(b);
+        return -1;
+    }
+    b[0] = 1;
+    size_t size = 1;
+    for (unsigned i = 0; i < n; i++) {
+        // (a, b) = (b, a + b), with the sum written over a
+        a[size] = 0;
+        if (bnAdd(a, a, size, b, size)) {
+            a[size] = 1;
+        }
+        size = bnNormalize(a, size + 1) > size ? size + 1 : size;
+        uint64_t* t = a;
+        a = b;
+        b = t;
+    }
+    free(b);
+    out->limbs = a;
+    out->size = bnNormalize(a, size);
+    return 0;
+}
+
+// x = x +/- v for a small v (the result must not go negative)
+static int addSmall(BigNum* x, uint64_t v, int subtract) {
+    BigNum small = {&v, v != 0};
+    return subtract ? bnSubBig(x, x, &small) : bnAddBig(x, x, &small);
+}
+
+typedef struct {
+    BigNum* value;
+    int threads;
+    int failed;
+} SquareJob;
+
+static void* squareThread(void* arg) {
+    SquareJob* job = arg;
+    job->failed = bnMulBig(job->value, job->value, job->value, job->threads) != 0;
+    return NULL;
+}
+
+// Exact F(n) by fast doubling on (F(k), F(k-1)) with two squarings per bit:
+//   F(2k+1) = 4 F(k)^2 - F(k-1)^2 + 2 (-1)^k
+//   F(2k-1) = F(k)^2 + F(k-1)^2
+//   F(2k)   = F(2k+1) - F(2k-1)
+// The two squarings are independent and run on two threads when large.
+int fibonacciBig(uint64_t n, int threads, BigNum* out) {
+    if (n == 0) {
+        *out = bnFromU64(0);
+        return out->limbs == NULL ? -1 : 0;
+    }
+    BigNum current = bnFromU64(1);          // F(k), starting at k = 1
+    BigNum previous = bnFromU64(0);         // F(k - 1)
+    int odd = 1;                            // Parity of k
+    int failed = current.limbs == NULL || previous.limbs == NULL;
+
+    for (int bit = 62 - __builtin_clzll(n); bit >= 0 && !failed; bit--) {
+        SquareJob job = {&previous, threads / 2, 0};
+        pthread_t id;
+        int started = threads >= 2 && current.size >= KARATSUBA_PARALLEL_LIMBS &&
+                      pthread_create(&id, NULL, squareThread, &job) == 0;
+        if (!started) {
+            job.failed = bnMulBig(&previous, &previous, &previous, threads) != 0;
+        }
+        failed = bnMulBig(&current, &current, &current, started ? threads - threads / 2 : threads) != 0;
+        if (started) {
+            pthread_join(id, NULL);
+        }
+        if (failed || job.failed) {
+            failed = 1;
+            break;
+        }
+
+        // previous = F(2k-1), current = F(2k+1)
+        BigNum sum = {NULL, 0};
+        BigNum quadruple = {malloc((current.size + 1) * sizeof(uint64_t)), current.size + 1};
+        if (quadruple.limbs == NULL || bnAddBig(&sum, &current, &previous) != 0) {
+            free(quadruple.limbs);
+            bnFree(&sum);
+            failed = 1;
+            break;
+        }
+        if (current.size > 0) {
+            bnShiftLeft(quadruple.limbs, current.limbs, current.size, 2);
+        }
+        quadruple.size = bnNormalize(quadruple.limbs, current.size + 1);
+        bnFree(&current);
+        current = quadruple;
+        if (bnSubBig(&current, &current, &previous) != 0 || addSmall(&current, 2, odd) != 0) {
+            bnFree(&sum);
+            failed = 1;
+            break;
+        }
+        bnFree(&previous);
+        previous = sum;
+
+        // F(2k) = F(2k+1) - F(2k-1); keep the pair that matches the bit
+        BigNum even = {NULL, 0};
+        if (bnSubBig(&even, &current, &previous) != 0) {
+            failed = 1;
+            break;
+        }
+        if ((n >> bit) & 1) {
+            bnFree(&previous);
+            previous = even;                // (F(2k+1), F(2k))
+            odd = 1;
+        } else {
+            bnFree(&current);
+            current = even;                 // (F(2k), F(2k-1))
+            odd = 0;
+        }
+    }
+    bnFree(&previous);
+    if (failed) {
+        bnFree(&current);
+        return -1;
+    }
+    *out = current;
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------
+
+static uint64_t nextRandom(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+#define QUERY_COUNT 1000000
+
+static void benchmarkFibonacci(int n) {
+    double start;
+    volatile uint64_t sink = 0;
+
+    // One value of F(n): the recursive version against the others
+    printf("F(%d), one call\n", n);
+    printf("%-28s %14s %22s\n", "method", "time per call", "value");
+    start = nowSeconds();
+    int recursive = fibonacciRecursive(n);
+    printf("%-28s %11.3f ms %22d\n", "recursive (tutorial)", (nowSeconds() - start) * 1e3, recursive);
+
+    unsigned query = (unsigned)n;
+    int repeat = 1000000;
+    start = nowSeconds();
+    for (int i = 0; i < repeat; i++) {
+        sink += fibonacciIterative(query + (i & 1));
+    }
+    printf("%-28s %11.1f ns %22llu\n", "iterative", (nowSeconds() - start) * 1e9 / repeat,
+           (unsigned long long)fibonacciIterative(query));
+    start = nowSeconds();
+    for (int i = 0; i < repeat; i++) {
+        sink += fibonacciFastDoubling(query + (i & 1));
+    }
+    printf("%-28s %11.1f ns %22llu\n", "fast doubling", (nowSeconds() - start) * 1e9 / repeat,
+           (unsigned long long)fibonacciFastDoubling(query));
+    FibonacciMemo memo;
+    if (initFibonacciMemo(&memo, 0) != 0) {
+        printf("Error: Out of memory\n");
+        return;
+    }
+    uint64_t value = 0;
+    start = nowSeconds();
+    for (int i = 0; i < repeat; i++) {
+        fibonacciMemo(&memo, query + (i & 1), &value);
+        sink += value;
+    }
+    fibonacciMemo(&memo, query, &value);
+    printf("%-28s %11.1f ns %22llu\n", "memo table", (nowSeconds() - start) * 1e9 / repeat,
+           (unsigned long long)value);
+
+    // Many random queries n <= 93
+    uint64_t* queries = malloc(QUERY_COUNT * sizeof(uint64_t));
+    if (queries == NULL) {
+        printf("Error: Out of memory\n");
+        freeFibonacciMemo(&memo);
+        return;
+    }
+    uint64_t state = 88172645463325252ULL;
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        queries[i] = nextRandom(&state) % (FIB_MAX_U64 + 1);
+    }
+    printf("\n%d random queries, 0 <= n <= %d\n", QUERY_COUNT, FIB_MAX_U64);
+    start = nowSeconds();
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        sink += fibonacciIterative((unsigned)queries[i]);
+    }
+    printf("%-28s %11.1f ns\n", "iterative", (nowSeconds() - start) * 1e9 / QUERY_COUNT);
+    start = nowSeconds();
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        sink += fibonacciFastDoubling(queries[i]);
+    }
+    printf("%-28s %11.1f ns\n", "fast doubling", (nowSeconds() - start) * 1e9 / QUERY_COUNT);
+    start = nowSeconds();
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        fibonacciMemo(&memo, queries[i], &value);
+        sink += value;
+    }
+    printf("%-28s %11.1f ns\n", "memo table", (nowSeconds() - start) * 1e9 / QUERY_COUNT);
+    freeFibonacciMemo(&memo);
+
+    // Random queries mod m with n up to 10^18
+    uint64_t moduli[] = {1000, 1000000007ULL};
+    for (int k = 0; k < 2; k++) {
+        uint64_t m = moduli[k];
+        for (int i = 0; i < QUERY_COUNT; i++) {
+            queries[i] = nextRandom(&state) % 1000000000000000000ULL;
+        }
+        printf("\n%d random queries mod %llu, n < 10^18\n", QUERY_COUNT, (unsigned long long)m);
+        start = nowSeconds();
+        for (int i = 0; i < QUERY_COUNT; i++) {
+            sink += fibonacciMod(queries[i], m);
+        }
+        printf("%-28s %11.1f ns\n", "fast doubling mod m", (nowSeconds() - start) * 1e9 / QUERY_COUNT);
+        if (initFibonacciMemo(&memo, m) != 0) {
+            printf("Error: Out of memory\n");
+            break;
+        }
+        int mismatches = 0;
+        start = nowSeconds();
+        for (int i = 0; i < QUERY_COUNT; i++) {
+            fibonacciMemo(&memo, queries[i], &value);
+            sink += value;
+        }
+        double seconds = nowSeconds() - start;
+        for (int i = 0; i < QUERY_COUNT; i += 97) {
+            fibonacciMemo(&memo, queries[i], &value);
+            mismatches += value != fibonacciMod(queries[i], m);
+        }
+        char name[64];
+        if (memo.period != 0) {
+            snprintf(name, sizeof(name), "memo table (period %llu)", (unsigned long long)memo.period);
+        } else {
+            snprintf(name, sizeof(name), "memo table (no period found)");
+        }
+        printf("%-28s %11.1f ns  %d mismatches\n", name, seconds * 1e9 / QUERY_COUNT, mismatches);
+        freeFibonacciMemo(&memo);
+    }
+    free(queries);
+
+    // Exact values
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    threads = threads > 0 ? threads : 1;
+    unsigned sizes[] = {10000, 100000, 1000000, 10000000};
+    printf("\nExact F(n)\n");
+    printf("%10s %12s %14s %14s %14s\n", "n", "digits", "O(n) adds", "fast doubling", "to decimal");
+    for (int k = 0; k < 4; k++) {
+        BigNum fast, slow = {NULL, 0};
+        start = nowSeconds();
+        if (fibonacciBig(sizes[k], threads, &fast) != 0) {
+            printf("Error: Out of memory\n");
+            break;
+        }
+        double fast_seconds = nowSeconds() - start;
+        double slow_seconds = -1;
+        if (sizes[k] <= 100000) {
+            start = nowSeconds();
+            if (fibonacciBigIterative(sizes[k], &slow) == 0) {
+                slow_seconds = nowSeconds() - start;
+                if (bnCompare(slow.limbs, slow.size, fast.limbs, fast.size) != 0) {
+                    printf("Error: F(%u) differs between methods\n", sizes[k]);
+                }
+            }
+            bnFree(&slow);
+        }
+        start = nowSeconds();
+        char* digits = bnToDecimal(&fast, threads);
+        double decimal_seconds = nowSeconds() - start;
+        if (digits == NULL) {
+            printf("Error: Out of memory\n");
+            bnFree(&fast);
+            break;
+        }
+        char slow_text[32] = "-";
+        if (slow_seconds >= 0) {
+            snprintf(slow_text, sizeof(slow_text), "%.4f s", slow_seconds);
+        }
+        printf("%10u %12zu %14s %12.4f s %12.4f s\n", sizes[k], strlen(digits), slow_text, fast_seconds,
+               decimal_seconds);
+        free(digits);
+        bnFree(&fast);
+    }
+    (void)sink;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 4 && strcmp(argv[1], "--mod") == 0) {
+        uint64_t n = strtoull(argv[2], NULL, 10), m = strtoull(argv[3], NULL, 10);
+        if (m == 0) {
+            printf("Error: The modulus must be at least 1\n");
+            return 1;
+        }
+        printf("F(%llu) mod %llu = %llu\n", (unsigned long long)n, (unsigned long long)m,
+               (unsigned long long)fibonacciMod(n, m));
+        return 0;
+    }
+    if (argc >= 3 && strcmp(argv[1], "--print") == 0) {
+        int threads = argc >= 4 ? atoi(argv[3]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+        BigNum value;
+        char* digits = NULL;
+        if (fibonacciBig(strtoull(argv[2], NULL, 10), threads, &value) != 0 ||
+            (digits = bnToDecimal(&value, threads)) == NULL) {
+            printf("Error: Out of memory\n");
+            return 1;
+        }
+        printf("%s\n", digits);
+        free(digits);
+        bnFree(&value);
+        return 0;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        int n = argc >= 3 ? atoi(argv[2]) : 32;
+        if (n < 0 || n > 46) {
+            printf("Error: The recursive version needs 0 <= N <= 46 (F(47) overflows an int)\n");
+            return 1;
+        }
+        benchmarkFibonacci(n);
+        return 0;
+    }
+
+    int n;
+    printf("Enter n to calculate the nth Fibonacci number: ");
+    if (scanf("%d", &n) != 1 || n < 0) {
+        printf("Error: Please enter a non-negative integer\n");
+        return 1;
+    }
+
+    printf("First %d Fibonacci numbers: ", n < 20 ? n + 1 : 20);
+    for (int i = 0; i <= n && i < 20; i++) {
+        printf("%llu ", (unsigned long long)fibonacciIterative((unsigned)i));
+    }
+    printf("\n");
+
+    if (n <= FIB_MAX_U64) {
+        printf("F(%d) = %llu\n", n, (unsigned long long)fibonacciFastDoubling((uint64_t)n));
+    } else {
+        // Past F(93) the value no longer fits in 64 bits
+        BigNum value;
+        char* digits = NULL;
+        if (fibonacciBig((uint64_t)n, 1, &value) != 0 || (digits = bnToDecimal(&value, 1)) == NULL) {
+            printf("Error: Out of memory\n");
+            return 1;
+        }
+        size_t len = strlen(digits);
+        if (len <= 1000) {
+            printf("F(%d) = %s\n", n, digits);
+        } else {
+            printf("F(%d) = %.40s...%s (%zu digits, --print %d shows all)\n", n, digits, digits + len - 40,
+                   len, n);
+        }
+        free(digits);
+        bnFree(&value);
+    }
+    printf("F(%d) mod 1000000007 = %llu\n", n, (unsigned long long)fibonacciMod((uint64_t)n, 1000000007ULL));
+
+    return 0;
+}
@@ -7,29 +7,442 @@
  * Features:
  * - Checks for negative input and handles it gracefully
  * - Calculates factorial using a loop
+ * - Exact results past 20! (where unsigned long long overflows), using the
+ *   bignum routines in basic_bigNum.h:
+ *   - Product tree: multiply 2..n in balanced halves, so the big
+ *     multiplications have equal-size operands and Karatsuba pays off
+ *   - Prime swing: n! = ((n/2)!)^2 * swing(n), where swing(n) is a product
+ *     of prime powers p^e with e = sum of floor(n / p^k) mod 2. Each level
+ *     does one squaring plus a product of only ~n / ln n small factors
+ *   - The upper subtrees of the product tree and the swing product run on
+ *     separate threads
+ *   - Decimal output by divide-and-conquer conversion
  * 
  * Usage: Compile and run the program
- * Example: gcc basic_Factorial.c -o basic_Factorial && ./basic_Factorial
+ * Example: gcc -O2 -pthread basic_Factorial.c -o basic_Factorial && ./basic_Factorial
+ *   ./basic_Factorial --print N [THREADS]   print every digit of N!
+ *   ./basic_Factorial --bench [N] [THREADS] time each method (default N = 10^6)
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "basic_bigNum.h"
+
+#define SMALL_FACTORIAL_MAX 20              // 20! is the largest that fits in 64 bits
+#define PRODUCT_LEAF 16                     // Factors multiplied one by one at a leaf
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int defaultThreads(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+static uint64_t smallFactorial(unsigned n) {
+    uint64_t result = 1;
+    for (unsigned i = 2; i <= n; i++) {
+        result *= i;
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Factor lists and the product tree
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint64_t* values;
+    size_t count;
+    size_t capacity;
+} FactorList;
+
+// Append a factor, merging it into the last entry while that still fits in
+// 64 bits (fewer, fuller leaves for the product tree)
+static int addFactor(FactorList* list, uint64_t factor) {
+    uint64_t merged;
+    if (list->count > 0 && !__builtin_mul_overflow(list->values[list->count - 1], factor, &merged)) {
+        list->values[list->count - 1] = merged;
+        return 0;
+    }
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+        uint64_t* values = realloc(list->values, capacity * sizeof(uint64_t));
+        if (values == NULL) {
+            return -1;
+        }
+        list->values = values;
+        list->capacity = capacity;
+    }
+    list->values[list->count++] = factor;
+    return 0;
+}
+
+typedef struct {
+    const uint64_t* factors;
+    size_t count;
+    int threads;
+    BigNum result;
+    int failed;
+} ProductJob;
+
+static void* productThread(void* arg);
+
+// Product of factors[0, count): leaves multiply in one limb at a time, inner
+// nodes multiply two balanced halves (the left half on a new thread while
+// threads remain)
+static int productTree(const uint64_t* factors, size_t count, int threads, BigNum* out) {
+    if (count <= PRODUCT_LEAF) {
+        out->limbs = malloc((count + 1) * sizeof(uint64_t));
+        if (out->limbs == NULL) {
+            return -1;
+        }
+        out->limbs[0] = 1;
+        out->size = 1;
+        for (size_t i = 0; i < count; i++) {
+            uint64_t carry = bnMul1(out->limbs, out->limbs, out->size, factors[i]);
+            if (carry != 0) {
+                out->limbs[out->size++] = carry;
+            }
+        }
+        return 0;
+    }
+
+    size_t half = count / 2;
+    ProductJob left = {factors, half, threads / 2, {NULL, 0}, 0};
+    BigNum right = {NULL, 0};
+    pthread_t id;
+    int started = threads >= 2 && pthread_create(&id, NULL, productThread, &left) == 0;
+    if (!started) {
+        left.failed = productTree(factors, half, 1, &left.result) != 0;
+    }
+    int failed = productTree(factors + half, count - half, started ? threads - threads / 2 : threads, &right);
+    if (started) {
+        pthread_join(id, NULL);
+    }
+    if (failed || left.failed || bnMulBig(out, &left.result, &right, threads) != 0) {
+        bnFree(&left.result);
+        bnFree(&right);
+        return -1;
+    }
+    bnFree(&left.result);
+    bnFree(&right);
+    return 0;
+}
+
+static void* productThread(void* arg) {
+    ProductJob* job = arg;
+    job->failed = productTree(job->factors, job->count, job->threads, &job->result) != 0;
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Factorial methods
+// ---------------------------------------------------------------------------
+
+// Multiply 2, 3, ..., n into one number a limb at a time (the baseline)
+int factorialNaive(unsigned n, BigNum* out) {
+    size_t capacity = 1 + (size_t)n;       // n! < n^n needs n * log2(n) / 64 < n limbs
+    out->limbs = malloc(capacity * sizeof(uint64_t));
+    if (out->limbs == NULL) {
+        return -1;
+    }
+    out->limbs[0] = 1;
+    out->size = 1;
+    for (unsigned i = 2; i <= n; i++) {
+        uint64_t carry = bnMul1(out->limbs, out->limbs, out->size, i);
+        if (carry != 0) {
+            out->limbs[out->size++] = carry;
+        }
+    }
+    return 0;
+}
+
+// n! as one product tree over 2..n
+int factorialProductTree(unsigned n, int threads, BigNum* out) {
+    FactorList list = {NULL, 0, 0};
+    for (unsigned i = 2; i <= n; i++) {
+        if (addFactor(&list, i) != 0) {
+            free(list.values);
+            return -1;
+        }
+    }
+    int result = productTree(list.values, list.count, threads, out);
+    free(list.values);
+    return result;
+}
+
+typedef struct {
+    unsigned n;
+    const unsigned char* composite;
+    int threads;
+    BigNum result;
+    int failed;
+} SwingJob;
+
+// swing(n) = n! / ((n/2)!)^2, as a product of prime powers
+static int primeSwing(unsigned n, const unsigned char* composite, int threads, BigNum* out) {
+    FactorList list = {NULL, 0, 0};
+    for (unsigned p = 2; p <= n; p++) {
+        if (composite[p]) {
+            continue;
+        }
+        uint64_t power = 1;
+        for (unsigned q = n / p; q > 0; q /= p) {
+            if (q & 1) {
+                power *= p;                     // p^e <= n, so this cannot overflow
+            }
+        }
+        if (power > 1 && addFactor(&list, power) != 0) {
+            free(list.values);
+            return -1;
+        }
+    }
+    int result = productTree(list.values, list.count, threads, out);
+    free(list.values);
+    return result;
+}
+
+static void* swingThread(void* arg) {
+    SwingJob* job = arg;
+    job->failed = primeSwing(job->n, job->composite, job->threads, &job->result) != 0;
+    return NULL;
+}
+
+static int factorialSwingRecursive(unsigned n, const unsigned char* composite, int threads, BigNum* out) {
+    if (n <= SMALL_FACTORIAL_MAX) {
+        *out = bnFromU64(smallFactorial(n));
+        return out->limbs == NULL ? -1 : 0;
+    }
+    // swing(n) does not depend on (n/2)!, so it can be built meanwhile
+    SwingJob swing = {n, composite, threads / 2, {NULL, 0}, 0};
+    pthread_t id;
+    int started = threads >= 2 && pthread_create(&id, NULL, swingThread, &swing) == 0;
+    if (!started) {
+        swing.failed = primeSwing(n, composite, threads, &swing.result) != 0;
+    }
+    BigNum half = {NULL, 0};
+    int failed = factorialSwingRecursive(n / 2, composite, started ? threads - threads / 2 : threads, &half);
+    if (started) {
+        pthread_join(id, NULL);
+    }
+    if (failed || swing.failed || bnMulBig(&half, &half, &half, threads) != 0 ||
+        bnMulBig(out, &half, &swing.result, threads) != 0) {
+        bnFree(&half);
+        bnFree(&swing.result);
+        return -1;
+    }
+    bnFree(&half);
+    bnFree(&swing.result);
+    return 0;
+}
+
+// n! by the prime-swing recursion
+int factorialPrimeSwing(unsigned n, int threads, BigNum* out) {
+    unsigned char* composite = calloc((size_t)n + 1, 1);
+    if (composite == NULL) {
+        return -1;
+    }
+    for (unsigned i = 2; (uint64_t)i * i <= n; i++) {
+        if (!composite[i]) {
+            for (unsigned j = i * i; j <= n; j += i) {
+                composite[j] = 1;
+            }
+        }
+    }
+    int result = factorialSwingRecursive(n, composite, threads, out);
+    free(composite);
+    return result;
+}
+
+// n! with the method that suits n
+int factorialBig(unsigned n, int threads, BigNum* out) {
+    if (n <= SMALL_FACTORIAL_MAX) {
+        *out = bnFromU64(smallFactorial(n));
+        return out->limbs == NULL ? -1 : 0;
+    }
+    return n < 2000 ? factorialProductTree(n, threads, out) : factorialPrimeSwing(n, threads, out);
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------
+
+// Decimal digits by repeated division by 10^19, the quadratic baseline
+static char* decimalNaive(const BigNum* x) {
+    size_t n = x->size;
+    uint64_t* copy = malloc((n + 1) * sizeof(uint64_t));
+    size_t chunks = 0;
+    uint64_t* parts = malloc((n * 2 + 1) * sizeof(uint64_t));
+    char* out = malloc(n * 20 + 2);
+    if (copy == NULL || parts == NULL || out == NULL) {
+        free(copy);
+        free(parts);
+        free(out);
+        return NULL;
+    }
+    memcpy(copy, x->limbs, n * sizeof(uint64_t));
+    while (n > 0) {
+        parts[chunks++] = bnDivmod1(copy, copy, n, DECIMAL_CHUNK);
+        n = bnNormalize(copy, n);
+    }
+    size_t len = 0;
+    if (chunks == 0) {
+        out[len++] = '0';
+    } else {
+        len += (size_t)sprintf(out, "%llu", (unsigned long long)parts[chunks - 1]);
+        for (size_t i = chunks - 1; i > 0; i--) {
+            len += (size_t)sprintf(out + len, "%019llu", (unsigned long long)parts[i - 1]);
+        }
+    }
+    out[len] = '\0';
+    free(copy);
+    free(parts);
+    return out;
+}
+
+static void benchRow(const char* name, double seconds, const BigNum* value, const BigNum* reference) {
+    const char* check = "";
+    if (value != NULL && reference != NULL) {
+        check = bnCompare(value->limbs, value->size, reference->limbs, reference->size) == 0 ? "same" : "DIFFERENT";
+    }
+    printf("%-32s %10.3f s  %s\n", name, seconds, check);
+}
+
+static void benchmarkFactorial(unsigned n, int threads) {
+    BigNum swing = {NULL, 0}, tree = {NULL, 0}, naive = {NULL, 0}, parallel = {NULL, 0};
+    printf("%u! with up to %d threads\n", n, threads);
+
+    double start = nowSeconds();
+    if (factorialPrimeSwing(n, 1, &swing) != 0) {
+        printf("Error: Out of memory\n");
+        return;
+    }
+    benchRow("prime swing, 1 thread", nowSeconds() - start, NULL, NULL);
+
+    if (threads > 1) {
+        start = nowSeconds();
+        if (factorialPrimeSwing(n, threads, &parallel) == 0) {
+            char name[64];
+            snprintf(name, sizeof(name), "prime swing, %d threads", threads);
+            benchRow(name, nowSeconds() - start, &parallel, &swing);
+        }
+        bnFree(&parallel);
+    }
+
+    start = nowSeconds();
+    if (factorialProductTree(n, threads, &tree) == 0) {
+        benchRow("product tree", nowSeconds() - start, &tree, &swing);
+    }
+    bnFree(&tree);
+
+    if (n <= 200000) {
+        start = nowSeconds();
+        if (factorialNaive(n, &naive) == 0) {
+            benchRow("one factor at a time", nowSeconds() - start, &naive, &swing);
+        }
+        bnFree(&naive);
+    } else {
+        printf("%-32s %12s  (quadratic, skipped above 200000)\n", "one factor at a time", "-");
+    }
+
+    start = nowSeconds();
+    char* digits = bnToDecimal(&swing, threads);
+    double seconds = nowSeconds() - start;
+    if (digits == NULL) {
+        printf("Error: Out of memory\n");
+        bnFree(&swing);
+        return;
+    }
+    benchRow("decimal, divide and conquer", seconds, NULL, NULL);
+    if (swing.size <= 20000) {
+        start = nowSeconds();
+        char* slow = decimalNaive(&swing);
+        seconds = nowSeconds() - start;
+        if (slow != NULL) {
+            printf("%-32s %10.3f s  %s\n", "decimal, repeated / 10^19", seconds,
+                   strcmp(slow, digits) == 0 ? "same" : "DIFFERENT");
+        }
+        free(slow);
+    } else {
+        printf("%-32s %12s  (quadratic, skipped above 20000 limbs)\n", "decimal, repeated / 10^19", "-");
+    }
+    size_t len = strlen(digits);
+    printf("%u! has %zu digits: %.20s...%s\n", n, len, digits, digits + (len > 20 ? len - 20 : 0));
+    free(digits);
+    bnFree(&swing);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 3 && strcmp(argv[1], "--print") == 0) {
+        BigNum result;
+        long value = atol(argv[2]);
+        int threads = argc >= 4 ? atoi(argv[3]) : defaultThreads();
+        if (value < 0) {
+            printf("Factorial is not defined for negative numbers.\n");
+            return 1;
+        }
+        char* digits = NULL;
+        if (factorialBig((unsigned)value, threads, &result) != 0 || (digits = bnToDecimal(&result, threads)) == NULL) {
+            printf("Error: Out of memory\n");
+            return 1;
+        }
+        printf("%s\n", digits);
+        free(digits);
+        bnFree(&result);
+        return 0;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        benchmarkFactorial(argc >= 3 ? (unsigned)atol(argv[2]) : 1000000,
+                           argc >= 4 ? atoi(argv[3]) : defaultThreads());
+        return 0;
+    }
 
-int main() {
     int n, i;
     unsigned long long factorial = 1;
 
     printf("Enter a positive integer: ");
-    scanf("%d", &n);
+    if (scanf("%d", &n) != 1) {
+        printf("Error: Please enter an integer\n");
+        return 1;
+    }
 
     if (n < 0)
         printf("Factorial is not defined for negative numbers.\n");
-    else {
+    else if (n <= SMALL_FACTORIAL_MAX) {
         for (i = 1; i <= n; ++i) {
             factorial *= i;
         }
         printf("Factorial of %d = %llu\n", n, factorial);
+    } else {
+        // Past 20! the value no longer fits: compute it exactly
+        BigNum result;
+        char* digits = NULL;
+        if (factorialBig((unsigned)n, defaultThreads(), &result) != 0 ||
+            (digits = bnToDecimal(&result, defaultThreads())) == NULL) {
+            printf("Error: Out of memory\n");
+            return 1;
+        }
+        size_t len = strlen(digits);
+        if (len <= 1000) {
+            printf("Factorial of %d = %s\n", n, digits);
+        } else {
+            printf("Factorial of %d = %.40s...%s (%zu digits, --print %d shows all)\n", n, digits,
+                   digits + len - 40, len, n);
+        }
+        free(digits);
+        bnFree(&result);
     }
 
     return 0;
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,756 @@
+/*
+ * Library: Arbitrary-Precision Natural Numbers
+ * Author: gpl-gowthamchand
+ * Date: 2026-10-18
+ * Description: Just enough bignum arithmetic for exact factorials and
+ *              Fibonacci numbers: add, subtract, Karatsuba multiply and
+ *              fast decimal output
+ *
+ * Numbers are little-endian arrays of 64-bit limbs. The low-level routines
+ * (bnAdd, bnMul, ...) work on raw limb arrays the caller sizes; BigNum wraps
+ * an array with its used length for everything else.
+ *
+ * Multiplication is schoolbook below KARATSUBA_THRESHOLD limbs and
+ * Karatsuba above it (three half-size products instead of four). For very
+ * large operands the top levels of the Karatsuba recursion run their three
+ * products on separate threads.
+ *
+ * Decimal output is divide and conquer: N is split by 10^(19 * 2^k) into a
+ * high and a low half whose digits are produced independently. Each split
+ * is a multiplication by a precomputed Newton reciprocal of the power plus
+ * a small correction, so conversion costs O(M(n) log n) instead of the
+ * O(n^2) of repeated division by 10^19.
+ *
+ * Usage:
+ *   #include "basic_bigNum.h"
+ *   BigNum x = bnFromU64(12345);
+ *   char* digits = bnToDecimal(&x, 1);
+ *
+ * Build with -pthread.
+ */
+
+#ifndef BASIC_BIG_NUM_H
+#define BASIC_BIG_NUM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#define KARATSUBA_THRESHOLD 32
+#define KARATSUBA_PARALLEL_LIMBS 4096       // Smallest product worth a thread
+#define DECIMAL_BASECASE_LIMBS 24
+#define DECIMAL_CHUNK 10000000000000000000ULL   // 10^19, the largest power of 10 in a limb
+
+typedef struct {
+    uint64_t* limbs;
+    size_t size;                            // Limbs in use; 0 means zero
+} BigNum;
+
+// ---------------------------------------------------------------------------
+// Limb-array primitives
+// ---------------------------------------------------------------------------
+
+static inline size_t bnNormalize(const uint64_t* a, size_t n) {
+    while (n > 0 && a[n - 1] == 0) {
+        n--;
+    }
+    return n;
+}
+
+// -1, 0 or 1 as a < b, a == b, a > b (both normalized)
+static inline int bnCompare(const uint64_t* a, size_t an, const uint64_t* b, size_t bn) {
+    if (an != bn) {
+        return an < bn ? -1 : 1;
+    }
+    while (an > 0) {
+        an--;
+        if (a[an] != b[an]) {
+            return a[an] < b[an] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// r = a + b with an >= bn; returns the carry out of limb an - 1. r may be a.
+static inline uint64_t bnAdd(uint64_t* r, const uint64_t* a, size_t an, const uint64_t* b, size_t bn) {
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < bn; i++) {
+        unsigned __int128 sum = (unsigned __int128)a[i] + b[i] + carry;
+        r[i] = (uint64_t)sum;
+        carry = (uint64_t)(sum >> 64);
+    }
+    for (; i < an; i++) {
+        uint64_t sum = a[i] + carry;
+        carry = sum < carry;
+        r[i] = sum;
+    }
+    return carry;
+}
+
+// r = a - b with an >= bn; returns the borrow. r may be a.
+static inline uint64_t bnSub(uint64_t* r, const uint64_t* a, size_t an, const uint64_t* b, size_t bn) {
+    uint64_t borrow = 0;
+    size_t i = 0;
+    for (; i < bn; i++) {
+        uint64_t x = a[i], y = b[i];
+        uint64_t diff = x - y - borrow;
+        borrow = (x < y) | ((x == y) & borrow);
+        r[i] = diff;
+    }
+    for (; i < an; i++) {
+        uint64_t x = a[i];
+        r[i] = x - borrow;
+        borrow = x < borrow;
+    }
+    return borrow;
+}
+
+// r = a * m; returns the high limb. r may be a.
+static inline uint64_t bnMul1(uint64_t* r, const uint64_t* a, size_t n, uint64_t m) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned __int128 product = (unsigned __int128)a[i] * m + carry;
+        r[i] = (uint64_t)product;
+        carry = (uint64_t)(product >> 64);
+    }
+    return carry;
+}
+
+// q = a / d; returns a % d. q may be a.
+static inline uint64_t bnDivmod1(uint64_t* q, const uint64_t* a, size_t n, uint64_t d) {
+    unsigned __int128 rem = 0;
+    for (size_t i = n; i > 0; i--) {
+        unsigned __int128 cur = (rem << 64) | a[i - 1];
+        q[i - 1] = (uint64_t)(cur / d);
+        rem = cur % d;
+    }
+    return (uint64_t)rem;
+}
+
+// r[0, an + bn) = a * b; r must not overlap a or b
+static inline void bnMulBasecase(uint64_t* r, const uint64_t* a, size_t an, const uint64_t* b, size_t bn) {
+    memset(r, 0, (an + bn) * sizeof(uint64_t));
+    for (size_t j = 0; j < bn; j++) {
+        uint64_t m = b[j], carry = 0;
+        for (size_t i = 0; i < an; i++) {
+            unsigned __int128 product = (unsigned __int128)a[i] * m + r[i + j] + carry;
+            r[i + j] = (uint64_t)product;
+            carry = (uint64_t)(product >> 64);
+        }
+        r[an + j] = carry;
+    }
+}
+
+// r[0, 2n) = a * a: each cross product a[i] a[j] once, doubled, plus the
+// squares on the diagonal (about half the multiplies of bnMulBasecase)
+static inline void bnSqrBasecase(uint64_t* r, const uint64_t* a, size_t n) {
+    memset(r, 0, 2 * n * sizeof(uint64_t));
+    for (size_t j = 1; j < n; j++) {
+        uint64_t m = a[j], carry = 0;
+        for (size_t i = 0; i < j; i++) {
+            unsigned __int128 product = (unsigned __int128)a[i] * m + r[i + j] + carry;
+            r[i + j] = (uint64_t)product;
+            carry = (uint64_t)(product >> 64);
+        }
+        r[2 * j] = carry;
+    }
+    uint64_t top = 0;
+    for (size_t i = 0; i < 2 * n; i++) {
+        uint64_t limb = r[i];
+        r[i] = (limb << 1) | top;
+        top = limb >> 63;
+    }
+    unsigned __int128 carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned __int128 square = (unsigned __int128)a[i] * a[i];
+        carry += (unsigned __int128)r[2 * i] + (uint64_t)square;
+        r[2 * i] = (uint64_t)carry;
+        carry = (carry >> 64) + r[2 * i + 1] + (uint64_t)(square >> 64);
+        r[2 * i + 1] = (uint64_t)carry;
+        carry >>= 64;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Karatsuba
+// ---------------------------------------------------------------------------
+
+// Scratch limbs bnKaratsuba() needs for an n-limb product
+static inline size_t bnKaratsubaScratch(size_t n) {
+    size_t total = 0;
+    while (n >= KARATSUBA_THRESHOLD) {
+        size_t high = n - n / 2;
+        total += 4 * high + 2;
+        n = high;
+    }
+    return total + 16;
+}
+
+static inline void bnKaratsuba(uint64_t* r, const uint64_t* a, const uint64_t* b, size_t n, uint64_t* scratch,
+                        int threads);
+
+typedef struct {
+    uint64_t* r;
+    const uint64_t* a;
+    const uint64_t* b;
+    size_t n;
+    uint64_t* scratch;
+    int threads;
+} KaratsubaJob;
+
+static inline void* bnKaratsubaThread(void* arg) {
+    KaratsubaJob* job = arg;
+    bnKaratsuba(job->r, job->a, job->b, job->n, job->scratch, job->threads);
+    return NULL;
+}
+
+// r[0, 2n) = a * b for n-limb a and b (a == b is fine, r must not overlap
+// either). With a = a1 B^h + a0 and b = b1 B^h + b0:
+//   a * b = a1 b1 B^2h + ((a0 + a1)(b0 + b1) - a0 b0 - a1 b1) B^h + a0 b0
+static inline void bnKaratsuba(uint64_t* r, const uint64_t* a, const uint64_t* b, size_t n, uint64_t* scratch,
+                        int threads) {
+    if (n < KARATSUBA_THRESHOLD) {
+        if (a == b) {
+            bnSqrBasecase(r, a, n);
+        } else {
+            bnMulBasecase(r, a, n, b, n);
+        }
+        return;
+    }
+    size_t low = n / 2, high = n - low;      // high >= low
+    uint64_t* sa = scratch;                  // a0 + a1, high limbs + carry
+    uint64_t* sb = sa + high;                // b0 + b1
+    uint64_t* middle = sb + high;            // 2 * high + 2 limbs
+    uint64_t* rest = middle + 2 * high + 2;
+
+    uint64_t carry_a = bnAdd(sa, a + low, high, a, low);
+    uint64_t carry_b = carry_a;
+    if (a == b) {
+        sb = sa;                             // Squaring: all three products are squares
+    } else {
+        carry_b = bnAdd(sb, b + low, high, b, low);
+    }
+
+    KaratsubaJob jobs[2] = {
+        {r, a, b, low, NULL, threads / 3},
+        {r + 2 * low, a + low, b + low, high, NULL, threads / 3},
+    };
+    pthread_t ids[2];
+    int started[2] = {0, 0};
+    if (threads >= 3 && n >= KARATSUBA_PARALLEL_LIMBS) {
+        for (int j = 0; j < 2; j++) {
+            jobs[j].scratch = malloc(bnKaratsubaScratch(jobs[j].n) * sizeof(uint64_t));
+            if (jobs[j].scratch != NULL) {
+                started[j] = pthread_create(&ids[j], NULL, bnKaratsubaThread, &jobs[j]) == 0;
+                if (!started[j]) {
+                    free(jobs[j].scratch);
+                }
+            }
+        }
+    }
+    bnKaratsuba(middle, sa, sb, high, rest, threads >= 3 ? threads / 3 : 1);
+    for (int j = 0; j < 2; j++) {
+        if (started[j]) {
+            pthread_join(ids[j], NULL);
+            free(jobs[j].scratch);
+        } else {
+            bnKaratsuba(jobs[j].r, jobs[j].a, jobs[j].b, jobs[j].n, rest, 1);
+        }
+    }
+
+    // Fold the carries of the two sums into the middle product
+    middle[2 * high] = 0;
+    middle[2 * high + 1] = 0;
+    if (carry_a) {
+        bnAdd(middle + high, middle + high, high + 2, sb, high);
+    }
+    if (carry_b) {
+        bnAdd(middle + high, middle + high, high + 2, sa, high);
+    }
+    if (carry_a && carry_b) {
+        uint64_t one = 1;
+        bnAdd(middle + 2 * high, middle + 2 * high, 2, &one, 1);
+    }
+    bnSub(middle, middle, 2 * high + 2, r, 2 * low);
+    bnSub(middle, middle, 2 * high + 2, r + 2 * low, 2 * high);
+    bnAdd(r + low, r + low, 2 * n - low, middle, bnNormalize(middle, 2 * high + 2));
+}
+
+// r[0, an + bn) = a * b, any sizes; r must not overlap a or b.
+// Returns -1 if scratch memory could not be allocated.
+static inline int bnMul(uint64_t* r, const uint64_t* a, size_t an, const uint64_t* b, size_t bn, int threads) {
+    if (an < bn) {
+        const uint64_t* t = a;
+        a = b;
+        b = t;
+        size_t tn = an;
+        an = bn;
+        bn = tn;
+    }
+    if (bn == 0) {
+        memset(r, 0, an * sizeof(uint64_t));
+        return 0;
+    }
+    if (bn < KARATSUBA_THRESHOLD) {
+        bnMulBasecase(r, a, an, b, bn);
+        return 0;
+    }
+    if (an == bn) {
+        uint64_t* scratch = malloc(bnKaratsubaScratch(an) * sizeof(uint64_t));
+        if (scratch == NULL) {
+            return -1;
+        }
+        bnKaratsuba(r, a, b, an, scratch, threads);
+        free(scratch);
+        return 0;
+    }
+
+    // Unbalanced: multiply b by bn-limb slices of a and add them up
+    uint64_t* slice = malloc(2 * bn * sizeof(uint64_t));
+    uint64_t* scratch = malloc(bnKaratsubaScratch(bn) * sizeof(uint64_t));
+    if (slice == NULL || scratch == NULL) {
+        free(slice);
+        free(scratch);
+        return -1;
+    }
+    memset(r, 0, (an + bn) * sizeof(uint64_t));
+    int result = 0;
+    for (size_t offset = 0; offset < an && result == 0; offset += bn) {
+        size_t len = an - offset < bn ? an - offset : bn;
+        if (len == bn) {
+            bnKaratsuba(slice, a + offset, b, bn, scratch, threads);
+        } else {
+            result = bnMul(slice, b, bn, a + offset, len, threads);
+        }
+        bnAdd(r + offset, r + offset, an + bn - offset, slice, len + bn);
+    }
+    free(slice);
+    free(scratch);
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// BigNum values
+// ---------------------------------------------------------------------------
+
+static inline void bnFree(BigNum* x) {
+    free(x->limbs);
+    x->limbs = NULL;
+    x->size = 0;
+}
+
+// Returns a zero-sized number with limbs == NULL if out of memory
+static inline BigNum bnFromU64(uint64_t value) {
+    BigNum x;
+    x.limbs = malloc(sizeof(uint64_t));
+    x.size = x.limbs != NULL && value != 0 ? 1 : 0;
+    if (x.limbs != NULL) {
+        x.limbs[0] = value;
+    }
+    return x;
+}
+
+// *out = x * y (out may be x or y); returns -1 on out of memory
+static inline int bnMulBig(BigNum* out, const BigNum* x, const BigNum* y, int threads) {
+    size_t size = x->size + y->size;
+    uint64_t* limbs = malloc((size + 1) * sizeof(uint64_t));
+    if (limbs == NULL || bnMul(limbs, x->limbs, x->size, y->limbs, y->size, threads) != 0) {
+        free(limbs);
+        return -1;
+    }
+    if (out == x || out == y) {
+        free(out->limbs);
+    }
+    out->limbs = limbs;
+    out->size = bnNormalize(limbs, size);
+    return 0;
+}
+
+// *out = x + y (out may be x or y); returns -1 on out of memory
+static inline int bnAddBig(BigNum* out, const BigNum* x, const BigNum* y) {
+    if (x->size < y->size) {
+        const BigNum* t = x;
+        x = y;
+        y = t;
+    }
+    uint64_t* limbs = malloc((x->size + 1) * sizeof(uint64_t));
+    if (limbs == NULL) {
+        return -1;
+    }
+    limbs[x->size] = bnAdd(limbs, x->limbs, x->size, y->limbs, y->size);
+    if (out == x || out == y) {
+        free(out->limbs);
+    }
+    out->limbs = limbs;
+    out->size = bnNormalize(limbs, x->size + 1);
+    return 0;
+}
+
+// *out = x - y for x >= y (out may be x or y); returns -1 on out of memory
+static inline int bnSubBig(BigNum* out, const BigNum* x, const BigNum* y) {
+    uint64_t* limbs = malloc((x->size + 1) * sizeof(uint64_t));
+    if (limbs == NULL) {
+        return -1;
+    }
+    bnSub(limbs, x->limbs, x->size, y->limbs, y->size);
+    if (out == x || out == y) {
+        free(out->limbs);
+    }
+    out->limbs = limbs;
+    out->size = bnNormalize(limbs, x->size);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Decimal conversion
+// ---------------------------------------------------------------------------
+
+// One split level: power = 10^(19 * 2^k) shifted left by `shift` bits so its
+// top bit is set, and inverse ~ B^(2j) / (top j limbs of power) from below
+// (B = 2^64). j is the full size except on the top level, whose quotients
+// are short and need only a few limbs of precision.
+typedef struct {
+    uint64_t* power;
+    size_t size;
+    unsigned shift;
+    uint64_t* inverse;                      // inverse_size + 1 limbs
+    size_t inverse_size;                    // j
+    size_t digits;                          // 19 * 2^k
+} DecimalLevel;
+
+// r = a << bits (0 <= bits < 64), n + 1 limbs out
+static inline void bnShiftLeft(uint64_t* r, const uint64_t* a, size_t n, unsigned bits) {
+    r[n] = bits ? a[n - 1] >> (64 - bits) : 0;
+    for (size_t i = n - 1; i > 0; i--) {
+        r[i] = bits ? (a[i] << bits) | (a[i - 1] >> (64 - bits)) : a[i];
+    }
+    r[0] = a[0] << bits;
+}
+
+// inverse[0, n + 1) = floor(B^(2n) / d) for a normalized n-limb d, bit by bit
+static inline void bnReciprocalBasecase(uint64_t* inverse, const uint64_t* d, size_t n) {
+    uint64_t rem[16] = {0};                 // n <= 4, so n + 1 limbs fit
+    memset(inverse, 0, (n + 1) * sizeof(uint64_t));
+    for (long bit = (long)(128 * n); bit >= 0; bit--) {
+        uint64_t top = rem[n] >> 63;
+        for (size_t i = n; i > 0; i--) {
+            rem[i] = (rem[i] << 1) | (rem[i - 1] >> 63);
+        }
+        rem[0] = (rem[0] << 1) | (bit == (long)(128 * n) ? 1 : 0);
+        if (top || bnCompare(rem, bnNormalize(rem, n + 1), d, n) >= 0) {
+            bnSub(rem, rem, n + 1, d, n);
+            if (bit < (long)(64 * (n + 1))) {
+                inverse[bit / 64] |= 1ULL << (bit % 64);
+            }
+        }
+    }
+}
+
+// inverse[0, n + 1) <= B^(2n) / d, short by at most a few units, for a
+// normalized n-limb d. The reciprocal of the top h limbs (h a little over
+// n / 2) is good to about h limbs; one Newton step x += x (B^2n - d x) / B^2n
+// doubles that. Newton's step never overshoots, so it stays a lower bound.
+static inline int bnReciprocal(uint64_t* inverse, const uint64_t* d, size_t n) {
+    if (n <= 4) {
+        bnReciprocalBasecase(inverse, d, n);
+        return 0;
+    }
+    size_t h = n / 2 + 2;
+    uint64_t* top = malloc((h + 1) * sizeof(uint64_t));
+    uint64_t* product = malloc((n + h + 2) * sizeof(uint64_t));
+    uint64_t* error = malloc((2 * n + 1) * sizeof(uint64_t));
+    uint64_t* step = malloc((2 * n + 2) * sizeof(uint64_t));
+    int result = -1;
+    if (top == NULL || product == NULL || error == NULL || step == NULL ||
+        bnReciprocal(top, d + n - h, h) != 0) {
+        goto done;
+    }
+
+    // Lower the top-limb reciprocal by 4 to cover the dropped low limbs
+    uint64_t four = 4;
+    if (bnSub(top, top, h + 1, &four, 1)) {
+        memset(top, 0, (h + 1) * sizeof(uint64_t));
+    }
+    size_t top_size = bnNormalize(top, h + 1);
+
+    // error = B^(2n) - d * x0, where x0 = top * B^(n - h)
+    memset(error, 0, (2 * n + 1) * sizeof(uint64_t));
+    if (top_size > 0) {
+        if (bnMul(product, d, n, top, top_size, 1) != 0) {
+            goto done;
+        }
+        memcpy(error + n - h, product, (n + top_size) * sizeof(uint64_t));
+    }
+    uint64_t* negated = error;              // B^(2n) - error, in place
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < 2 * n; i++) {
+        uint64_t x = negated[i];
+        negated[i] = 0 - x - borrow;
+        borrow = (x | borrow) != 0;
+    }
+    size_t error_size = bnNormalize(error, 2 * n);
+
+    // x1 = x0 + x0 * error / B^(2n) = top * B^(n - h) + top * error / B^(n + h).
+    // Limbs of error below B^(n - 2) move x1 by less than one unit, so only
+    // the top (about h) limbs of error take part in the product.
+    memset(inverse, 0, (n + 1) * sizeof(uint64_t));
+    memcpy(inverse + n - h, top, (top_size < h + 1 ? top_size : h + 1) * sizeof(uint64_t));
+    if (top_size > 0 && error_size > n - 2) {
+        size_t high_size = error_size - (n - 2);
+        if (bnMul(step, top, top_size, error + n - 2, high_size, 1) != 0) {
+            goto done;
+        }
+        size_t step_size = top_size + high_size;
+        if (step_size > h + 2) {
+            bnAdd(inverse, inverse, n + 1, step + h + 2, step_size - (h + 2));
+        }
+    }
+    result = 0;
+done:
+    free(top);
+    free(product);
+    free(error);
+    free(step);
+    return result;
+}
+
+static inline void freeDecimalLevels(DecimalLevel* levels, int count) {
+    for (int k = 0; k < count; k++) {
+        free(levels[k].power);
+        free(levels[k].inverse);
+    }
+}
+
+// Build 10^(19 * 2^k) and its reciprocal for k = 0, 1, ... until the next
+// power would be larger than any n-limb number. Returns the level count or -1.
+static inline int buildDecimalLevels(DecimalLevel* levels, int max_levels, size_t n, int threads) {
+    uint64_t* power = malloc(sizeof(uint64_t));
+    size_t size = 1;
+    int count = 0;
+    if (power == NULL) {
+        return -1;
+    }
+    power[0] = DECIMAL_CHUNK;
+    for (;;) {
+        DecimalLevel* level = &levels[count];
+        unsigned shift = (unsigned)__builtin_clzll(power[size - 1]);
+        level->power = malloc((size + 1) * sizeof(uint64_t));
+        level->inverse = malloc((size + 1) * sizeof(uint64_t));
+        if (level->power == NULL || level->inverse == NULL) {
+            free(level->power);
+            free(level->inverse);
+            free(power);
+            freeDecimalLevels(levels, count);
+            return -1;
+        }
+        bnShiftLeft(level->power, power, size, shift);
+        level->size = size;
+        level->shift = shift;
+        level->digits = (size_t)19 << count;
+        // The top level divides numbers of at most n + 1 limbs, so its
+        // quotients have at most n - size + 2 limbs
+        int last = 2 * size > n + 1 || count + 1 == max_levels;
+        size_t precision = last && n + 4 < 2 * size ? n - size + 4 : size;
+        level->inverse_size = precision;
+        if (bnReciprocal(level->inverse, level->power + size - precision, precision) != 0) {
+            free(power);
+            freeDecimalLevels(levels, count + 1);
+            return -1;
+        }
+        count++;
+        if (last) {
+            break;
+        }
+        uint64_t* square = malloc(2 * size * sizeof(uint64_t));
+        if (square == NULL || bnMul(square, power, size, power, size, threads) != 0) {
+            free(square);
+            free(power);
+            freeDecimalLevels(levels, count);
+            return -1;
+        }
+        free(power);
+        power = square;
+        size = bnNormalize(square, 2 * size);
+    }
+    free(power);
+    return count;
+}
+
+// Divide a (n limbs) by the level's power: q gets up to n - size + 2 limbs,
+// r gets size limbs. Works on a shifted like the power, so the quotient is
+// unchanged and the remainder comes out shifted back.
+static inline int decimalSplit(const DecimalLevel* level, const uint64_t* a, size_t n, uint64_t* q, size_t* qn,
+                        uint64_t* r, size_t* rn, int threads) {
+    size_t m = level->size;
+    size_t j = level->inverse_size;
+    uint64_t* shifted = malloc((n + 2) * sizeof(uint64_t));
+    uint64_t* product = malloc((n + j + 4) * sizeof(uint64_t));
+    if (shifted == NULL || product == NULL) {
+        free(shifted);
+        free(product);
+        return -1;
+    }
+    shifted[n + 1] = 0;
+    bnShiftLeft(shifted, a, n, level->shift);
+    size_t sn = bnNormalize(shifted, n + 1);
+
+    // q ~ (shifted / B^(m - 1)) * inverse / B^(j + 1): the limbs of shifted
+    // below B^(m - 1) change the quotient by less than one unit
+    size_t in = bnNormalize(level->inverse, j + 1);
+    size_t quotient_size = 0;
+    if (sn >= m && in > 0) {
+        size_t hn = sn - (m - 1);
+        if (bnMul(product, shifted + m - 1, hn, level->inverse, in, threads) != 0) {
+            free(shifted);
+            free(product);
+            return -1;
+        }
+        if (hn + in > j + 1) {
+            quotient_size = hn + in - (j + 1);
+            memcpy(q, product + j + 1, quotient_size * sizeof(uint64_t));
+        }
+    }
+    quotient_size = bnNormalize(q, quotient_size);
+    if (j < m && quotient_size > 0) {
+        // A truncated power can push the estimate one unit over
+        uint64_t one = 1;
+        bnSub(q, q, quotient_size, &one, 1);
+        quotient_size = bnNormalize(q, quotient_size);
+    }
+
+    // remainder = shifted - q * power, then fix the few units q is short by
+    if (quotient_size > 0) {
+        if (bnMul(product, q, quotient_size, level->power, m, threads) != 0) {
+            free(shifted);
+            free(product);
+            return -1;
+        }
+        bnSub(shifted, shifted, sn, product, bnNormalize(product, quotient_size + m));
+    }
+    sn = bnNormalize(shifted, sn);
+    while (bnCompare(shifted, sn, level->power, m) >= 0) {
+        uint64_t one = 1;
+        bnSub(shifted, shifted, sn, level->power, m);
+        sn = bnNormalize(shifted, sn);
+        q[quotient_size] = 0;
+        bnAdd(q, q, quotient_size + 1, &one, 1);
+        quotient_size = bnNormalize(q, quotient_size + 1);
+    }
+
+    // Undo the shift on the remainder (it is a multiple of 2^shift)
+    memset(r, 0, m * sizeof(uint64_t));
+    for (size_t i = 0; i < sn && i < m; i++) {
+        uint64_t next = i + 1 < sn ? shifted[i + 1] : 0;
+        r[i] = level->shift ? (shifted[i] >> level->shift) | (next << (64 - level->shift)) : shifted[i];
+    }
+    *qn = quotient_size;
+    *rn = bnNormalize(r, m);
+    free(shifted);
+    free(product);
+    return 0;
+}
+
+// Write exactly `width` digits of a (zero-padded) by repeated division by 10^19
+static inline void decimalBasecase(const uint64_t* a, size_t n, char* out, size_t width) {
+    uint64_t copy[DECIMAL_BASECASE_LIMBS * 2 + 2];
+    memcpy(copy, a, n * sizeof(uint64_t));
+    memset(out, '0', width);
+    size_t pos = width;
+    while (n > 0 && pos > 0) {
+        uint64_t chunk = bnDivmod1(copy, copy, n, DECIMAL_CHUNK);
+        n = bnNormalize(copy, n);
+        for (int d = 0; d < 19 && pos > 0; d++) {
+            out[--pos] = (char)('0' + chunk % 10);
+            chunk /= 10;
+        }
+    }
+}
+
+typedef struct {
+    const DecimalLevel* levels;
+    const uint64_t* a;
+    size_t n;
+    int level;
+    char* out;
+    int threads;
+    int failed;
+} DecimalJob;
+
+static inline void* decimalPaddedThread(void* arg);
+
+// Write exactly 2 * levels[level].digits digits of a (< power(level)^2)
+static inline int decimalPadded(const DecimalLevel* levels, const uint64_t* a, size_t n, int level, char* out,
+                         int threads) {
+    size_t width = 2 * levels[level].digits;
+    if (n <= DECIMAL_BASECASE_LIMBS || level == 0) {
+        decimalBasecase(a, n, out, width);
+        return 0;
+    }
+    size_t m = levels[level].size;
+    uint64_t* q = malloc((n + 3) * sizeof(uint64_t));
+    uint64_t* r = malloc((m + 1) * sizeof(uint64_t));
+    size_t qn, rn;
+    if (q == NULL || r == NULL || decimalSplit(&levels[level], a, n, q, &qn, r, &rn, threads) != 0) {
+        free(q);
+        free(r);
+        return -1;
+    }
+    size_t half = levels[level].digits;
+    int result = 0;
+    DecimalJob job = {levels, r, rn, level - 1, out + half, threads / 2, 0};
+    pthread_t id;
+    int started = threads >= 2 && n >= KARATSUBA_PARALLEL_LIMBS &&
+                  pthread_create(&id, NULL, decimalPaddedThread, &job) == 0;
+    result |= decimalPadded(levels, q, qn, level - 1, out, started ? threads - threads / 2 : threads);
+    if (started) {
+        pthread_join(id, NULL);
+        result |= job.failed;
+    } else {
+        result |= decimalPadded(levels, r, rn, level - 1, out + half, threads);
+    }
+    free(q);
+    free(r);
+    return result ? -1 : 0;
+}
+
+static inline void* decimalPaddedThread(void* arg) {
+    DecimalJob* job = arg;
+    job->failed = decimalPadded(job->levels, job->a, job->n, job->level, job->out, job->threads) != 0;
+    return NULL;
+}
+
+// Decimal digits of x as a malloc'd string, NULL if out of memory
+static inline char* bnToDecimal(const BigNum* x, int threads) {
+    size_t n = x->size;
+    if (n == 0) {
+        char* zero = malloc(2);
+        if (zero != NULL) {
+            strcpy(zero, "0");
+        }
+        return zero;
+    }
+    DecimalLevel levels[64];
+    int count = buildDecimalLevels(levels, 64, n, threads);
+    if (count < 0) {
+        return NULL;
+    }
+    // Top level whose square covers x: pad to that width, then strip zeros
+    int top = count - 1;
+    size_t width = 2 * levels[top].digits;
+    char* out = malloc(width + 1);
+    if (out == NULL || decimalPadded(levels, x->limbs, n, top, out, threads) != 0) {
+        free(out);
+        freeDecimalLevels(levels, count);
+        return NULL;
+    }
+    out[width] = '\0';
+    freeDecimalLevels(levels, count);
+    size_t skip = strspn(out, "0");
+    memmove(out, out + skip, width - skip + 1);
+    return out;
+}
+
+#endif
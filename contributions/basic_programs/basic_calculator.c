@@ -3,49 +3,1714 @@
  * Author: gpl-gowthamchand
  * Date: 2025-01-27
  * Description: Simple calculator for basic arithmetic operations
+ *
+ * Features:
+ * - Whole expressions instead of one operation: 2 * (3 + 4) ^ 2 / 7
+ * - Operators + - * / % ^ (power, right-associative), unary minus,
+ *   parentheses, the constants pi and e, and the functions abs, sqrt, exp,
+ *   log, sin, cos, tan, min(a, b) and max(a, b)
+ * - Variables: any other name, e.g. x * x + 3 * y
+ * - Expressions are compiled once, then evaluated over as many variable
+ *   bindings as needed:
+ *   - Tokenizer: character classes come from practice_charClass.h
+ *   - Pratt parser: each operator has a binding power, so precedence and
+ *     associativity are one table instead of one function per level
+ *   - Compiler: emits a compact stack-machine bytecode while parsing
+ *   - Constant folding: an operator whose operands are all constants is
+ *     computed at compile time (2 * pi / 4 becomes one constant)
+ *   - Division by zero does not stop evaluation; it sets a status flag
+ * - Column mode: one expression over whole columns of values from a CSV
+ *   file (header line of names) or a binary file of column-major doubles.
+ *   The bytecode runs once per block of 1024 rows, each instruction a SIMD
+ *   loop over the block, and division by zero marks just the rows it hits.
+ * - JIT (x86-64): --jit compiles the expression to native SSE2 code in an
+ *   executable mapping, two rows per instruction and one register per stack
+ *   slot; other machines, and very deep expressions, use the interpreter.
+ *
+ * Usage: gcc -O2 basic_calculator.c -o basic_calculator -lm && ./basic_calculator
+ *   ./basic_calculator --eval "EXPR" [name=value ...]   evaluate once
+ *   ./basic_calculator --disasm "EXPR"                  show the bytecode
+ *   ./basic_calculator --columns "EXPR" FILE [--names a,b,...] [--out FILE] [--jit]
+ *       evaluate over every row of FILE (.csv, or binary columns named by
+ *       --names or in the expression's order); --out writes the results
+ *       (.csv with a division-by-zero flag, otherwise binary doubles)
+ *   ./basic_calculator --bench [MILLIONS]               compiled vs re-parsed
+ *   ./basic_calculator --bench-columns [MILLIONS]       rows vs column blocks
+ *   ./basic_calculator --bench-jit [MILLIONS]           interpreters vs JIT vs C
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-int main() {
-    char operator;
-    double num1, num2, result;
-    
-    printf("=== Basic Calculator ===\n");
-    printf("Enter an operator (+, -, *, /): ");
-    scanf("%c", &operator);
-    
-    printf("Enter two numbers: ");
-    scanf("%lf %lf", &num1, &num2);
-    
-    switch(operator) {
-        case '+':
-            result = num1 + num2;
-            printf("%.2lf + %.2lf = %.2lf\n", num1, num2, result);
-            break;
-            
-        case '-':
-            result = num1 - num2;
-            printf("%.2lf - %.2lf = %.2lf\n", num1, num2, result);
-            break;
-            
-        case '*':
-            result = num1 * num2;
-            printf("%.2lf * %.2lf = %.2lf\n", num1, num2, result);
-            break;
-            
-        case '/':
-            if (num2 != 0) {
-                result = num1 / num2;
-                printf("%.2lf / %.2lf = %.2lf\n", num1, num2, result);
+#include "../practice_problems/practice_charClass.h"
+
+#define EXPR_MAX_CODE 1024                  // Bytes of bytecode per expression
+#define EXPR_MAX_CONSTANTS 256
+#define EXPR_MAX_VARS 16
+#define EXPR_MAX_NAME 32
+#define EXPR_MAX_STACK 64                   // Also bounds the nesting depth
+#define EVAL_DIV_ZERO 0x01                  // Status bit: some divisor was zero
+#define COLUMN_BLOCK 1024                   // Rows per block in column evaluation
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ---------------------------------------------------------------------------
+// Bytecode
+// ---------------------------------------------------------------------------
+
+// OP_CONST and OP_VAR take a one-byte operand; every other opcode is one byte
+enum {
+    OP_CONST, OP_VAR,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_POW, OP_MIN, OP_MAX,
+    OP_NEG, OP_ABS, OP_SQRT, OP_EXP, OP_LOG, OP_SIN, OP_COS, OP_TAN,
+    OP_COUNT
+};
+
+static const char* opNames[OP_COUNT] = {
+    "const", "var", "add", "sub", "mul", "div", "mod", "pow", "min", "max",
+    "neg", "abs", "sqrt", "exp", "log", "sin", "cos", "tan",
+};
+
+typedef struct {
+    const char* name;
+    int arity;
+    uint8_t op;
+} Function;
+
+static const Function functions[] = {
+    {"abs", 1, OP_ABS}, {"sqrt", 1, OP_SQRT}, {"exp", 1, OP_EXP}, {"log", 1, OP_LOG},
+    {"sin", 1, OP_SIN}, {"cos", 1, OP_COS}, {"tan", 1, OP_TAN},
+    {"min", 2, OP_MIN}, {"max", 2, OP_MAX},
+};
+
+typedef struct {
+    uint8_t code[EXPR_MAX_CODE];
+    size_t length;
+    double constants[EXPR_MAX_CONSTANTS];
+    int constantCount;
+    char names[EXPR_MAX_VARS][EXPR_MAX_NAME];
+    int varCount;
+    int maxStack;
+    char error[128];
+} Program;
+
+// The arithmetic of every operator, shared by constant folding and the
+// interpreter (b is unused by unary operators)
+static inline double applyOperator(uint8_t op, double a, double b) {
+    switch (op) {
+        case OP_ADD: return a + b;
+        case OP_SUB: return a - b;
+        case OP_MUL: return a * b;
+        case OP_DIV: return a / b;
+        case OP_MOD: return fmod(a, b);
+        case OP_POW: return pow(a, b);
+        case OP_MIN: return a < b ? a : b;
+        case OP_MAX: return a > b ? a : b;
+        case OP_NEG: return -a;
+        case OP_ABS: return fabs(a);
+        case OP_SQRT: return sqrt(a);
+        case OP_EXP: return exp(a);
+        case OP_LOG: return log(a);
+        case OP_SIN: return sin(a);
+        case OP_COS: return cos(a);
+        case OP_TAN: return tan(a);
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Tokenizer
+// ---------------------------------------------------------------------------
+
+typedef enum {
+    TOKEN_NUMBER, TOKEN_NAME, TOKEN_OPERATOR, TOKEN_LPAREN, TOKEN_RPAREN,
+    TOKEN_COMMA, TOKEN_END, TOKEN_ERROR
+} TokenType;
+
+typedef struct {
+    TokenType type;
+    size_t start, length;                   // Where the token is in the text
+    double number;
+    char symbol;                            // The operator character
+} Token;
+
+typedef struct {
+    const char* text;
+    size_t pos;
+    Token token;                            // Current (lookahead) token
+    Program* program;
+    int depth;                              // Current stack depth
+    int nesting;
+} Parser;
+
+static void nextToken(Parser* parser) {
+    const char* text = parser->text;
+    size_t pos = parser->pos;
+    while (charIsSpace(text[pos])) {
+        pos++;
+    }
+    Token* token = &parser->token;
+    token->start = pos;
+    char c = text[pos];
+    if (c == '\0') {
+        token->type = TOKEN_END;
+    } else if (charIsDigit(c) || (c == '.' && charIsDigit(text[pos + 1]))) {
+        char* end;
+        token->type = TOKEN_NUMBER;
+        token->number = strtod(text + pos, &end);
+        pos = (size_t)(end - text);
+    } else if (charIsAlpha(c) || c == '_') {
+        token->type = TOKEN_NAME;
+        while (charIsAlnum(text[pos]) || text[pos] == '_') {
+            pos++;
+        }
+    } else {
+        pos++;
+        token->symbol = c;
+        token->type = c == '(' ? TOKEN_LPAREN : c == ')' ? TOKEN_RPAREN : c == ',' ? TOKEN_COMMA
+                    : strchr("+-*/%^", c) != NULL ? TOKEN_OPERATOR : TOKEN_ERROR;
+    }
+    token->length = pos - token->start;
+    parser->pos = pos;
+}
+
+static int tokenIs(const Parser* parser, const char* name) {
+    return parser->token.length == strlen(name) &&
+           strncmp(parser->text + parser->token.start, name, parser->token.length) == 0;
+}
+
+// ---------------------------------------------------------------------------
+// Compiler: a Pratt parser that emits bytecode as it goes
+// ---------------------------------------------------------------------------
+
+static int parseError(Parser* parser, const char* message) {
+    if (parser->program->error[0] == '\0') {
+        snprintf(parser->program->error, sizeof(parser->program->error), "%s at column %zu", message,
+                 parser->token.start + 1);
+    }
+    return -1;
+}
+
+static int emitByte(Parser* parser, uint8_t byte) {
+    Program* program = parser->program;
+    if (program->length == EXPR_MAX_CODE) {
+        return parseError(parser, "Expression too long");
+    }
+    program->code[program->length++] = byte;
+    return 0;
+}
+
+// Change the stack depth by delta, tracking the deepest point
+static int adjustDepth(Parser* parser, int delta) {
+    parser->depth += delta;
+    if (parser->depth > EXPR_MAX_STACK) {
+        return parseError(parser, "Expression too deeply nested");
+    }
+    if (parser->depth > parser->program->maxStack) {
+        parser->program->maxStack = parser->depth;
+    }
+    return 0;
+}
+
+static int emitConstant(Parser* parser, double value) {
+    Program* program = parser->program;
+    if (program->constantCount == EXPR_MAX_CONSTANTS) {
+        return parseError(parser, "Too many constants");
+    }
+    program->constants[program->constantCount] = value;
+    if (emitByte(parser, OP_CONST) != 0 || emitByte(parser, (uint8_t)program->constantCount) != 0) {
+        return -1;
+    }
+    program->constantCount++;
+    return adjustDepth(parser, 1);
+}
+
+// Emit an operator over the top `arity` values. When those values are the
+// constants just emitted, compute the result now and emit it instead;
+// *constant says whether that happened.
+static int emitOperator(Parser* parser, uint8_t op, int arity, const int* operands, int* constant) {
+    Program* program = parser->program;
+    int folding = 1;
+    for (int i = 0; i < arity; i++) {
+        folding &= operands[i];
+    }
+    double b = folding && arity == 2 ? program->constants[program->constantCount - 1] : 0;
+    if (folding && (op == OP_DIV || op == OP_MOD) && b == 0) {
+        folding = 0;                        // Leave it to run time, which reports it
+    }
+    *constant = folding;
+    if (folding) {
+        double a = program->constants[program->constantCount - arity];
+        program->length -= 2 * (size_t)arity;
+        program->constantCount -= arity;
+        parser->depth -= arity;
+        return emitConstant(parser, applyOperator(op, a, b));
+    }
+    if (emitByte(parser, op) != 0) {
+        return -1;
+    }
+    return adjustDepth(parser, 1 - arity);
+}
+
+static int variableIndex(Parser* parser) {
+    Program* program = parser->program;
+    for (int i = 0; i < program->varCount; i++) {
+        if (tokenIs(parser, program->names[i])) {
+            return i;
+        }
+    }
+    if (program->varCount == EXPR_MAX_VARS || parser->token.length >= EXPR_MAX_NAME) {
+        return parseError(parser, program->varCount == EXPR_MAX_VARS ? "Too many variables" : "Name too long");
+    }
+    memcpy(program->names[program->varCount], parser->text + parser->token.start, parser->token.length);
+    program->names[program->varCount][parser->token.length] = '\0';
+    return program->varCount++;
+}
+
+#define POWER_SUM 10
+#define POWER_PRODUCT 20
+#define POWER_PREFIX 30                     // Unary minus: -2^2 is -(2^2)
+#define POWER_EXPONENT 40
+
+// Left binding power of a binary operator, or 0 if the token is not one
+static int bindingPower(const Token* token, uint8_t* op) {
+    if (token->type != TOKEN_OPERATOR) {
+        return 0;
+    }
+    switch (token->symbol) {
+        case '+': *op = OP_ADD; return POWER_SUM;
+        case '-': *op = OP_SUB; return POWER_SUM;
+        case '*': *op = OP_MUL; return POWER_PRODUCT;
+        case '/': *op = OP_DIV; return POWER_PRODUCT;
+        case '%': *op = OP_MOD; return POWER_PRODUCT;
+        case '^': *op = OP_POW; return POWER_EXPONENT;
+    }
+    return 0;
+}
+
+static int parseExpression(Parser* parser, int min_power, int* constant);
+
+// name(arg, ...) with the name as the current token
+static int parseCall(Parser* parser, int* constant) {
+    const Function* function = NULL;
+    for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); i++) {
+        if (tokenIs(parser, functions[i].name)) {
+            function = &functions[i];
+        }
+    }
+    if (function == NULL) {
+        return parseError(parser, "Unknown function");
+    }
+    nextToken(parser);                      // The name
+    nextToken(parser);                      // '('
+    int args[2];
+    for (int i = 0; i < function->arity; i++) {
+        if (i > 0) {
+            if (parser->token.type != TOKEN_COMMA) {
+                return parseError(parser, "Expected ','");
+            }
+            nextToken(parser);
+        }
+        if (parseExpression(parser, 0, &args[i]) != 0) {
+            return -1;
+        }
+    }
+    if (parser->token.type != TOKEN_RPAREN) {
+        return parseError(parser, function->arity == 1 ? "Expected ')'" : "Expected ')' after the arguments");
+    }
+    nextToken(parser);
+    return emitOperator(parser, function->op, function->arity, args, constant);
+}
+
+// A number, name, call, parenthesized expression or unary minus/plus
+static int parsePrefix(Parser* parser, int* constant) {
+    Token token = parser->token;
+    switch (token.type) {
+        case TOKEN_NUMBER:
+            nextToken(parser);
+            *constant = 1;
+            return emitConstant(parser, token.number);
+        case TOKEN_NAME: {
+            size_t after = parser->pos;
+            while (charIsSpace(parser->text[after])) {
+                after++;
+            }
+            if (parser->text[after] == '(') {
+                return parseCall(parser, constant);
+            }
+            if (tokenIs(parser, "pi") || tokenIs(parser, "e")) {
+                *constant = 1;
+                nextToken(parser);
+                return emitConstant(parser, token.length == 2 ? 3.14159265358979323846 : 2.71828182845904523536);
+            }
+            int index = variableIndex(parser);
+            if (index < 0) {
+                return -1;
+            }
+            nextToken(parser);
+            *constant = 0;
+            if (emitByte(parser, OP_VAR) != 0 || emitByte(parser, (uint8_t)index) != 0) {
+                return -1;
+            }
+            return adjustDepth(parser, 1);
+        }
+        case TOKEN_LPAREN:
+            nextToken(parser);
+            if (parseExpression(parser, 0, constant) != 0) {
+                return -1;
+            }
+            if (parser->token.type != TOKEN_RPAREN) {
+                return parseError(parser, "Expected ')'");
+            }
+            nextToken(parser);
+            return 0;
+        case TOKEN_OPERATOR:
+            if (token.symbol == '-' || token.symbol == '+') {
+                nextToken(parser);
+                int operand;
+                if (parseExpression(parser, POWER_PREFIX, &operand) != 0) {
+                    return -1;
+                }
+                *constant = operand;
+                return token.symbol == '-' ? emitOperator(parser, OP_NEG, 1, &operand, constant) : 0;
+            }
+            return parseError(parser, "Expected a value");
+        case TOKEN_END:
+            return parseError(parser, "Unexpected end of expression");
+        default:
+            return parseError(parser, "Unexpected character");
+    }
+}
+
+// Parse operators that bind tighter than min_power. *constant says whether
+// the whole subexpression folded to one constant.
+static int parseExpression(Parser* parser, int min_power, int* constant) {
+    if (++parser->nesting > EXPR_MAX_STACK) {
+        return parseError(parser, "Expression too deeply nested");
+    }
+    if (parsePrefix(parser, constant) != 0) {
+        return -1;
+    }
+    uint8_t op = 0;
+    int power;
+    while ((power = bindingPower(&parser->token, &op)) > min_power) {
+        nextToken(parser);
+        // ^ is right-associative: its right side may hold another ^
+        int operands[2] = {*constant, 0};
+        if (parseExpression(parser, op == OP_POW ? power - 1 : power, &operands[1]) != 0 ||
+            emitOperator(parser, op, 2, operands, constant) != 0) {
+            return -1;
+        }
+    }
+    parser->nesting--;
+    return 0;
+}
+
+// Compile text into program. Returns -1 with program->error set on a syntax
+// error.
+int compileExpression(const char* text, Program* program) {
+    Parser parser = {text, 0, {0}, program, 0, 0};
+    program->length = 0;
+    program->constantCount = 0;
+    program->varCount = 0;
+    program->maxStack = 0;
+    program->error[0] = '\0';
+    nextToken(&parser);
+    int constant;
+    if (parseExpression(&parser, 0, &constant) != 0) {
+        return -1;
+    }
+    if (parser.token.type != TOKEN_END) {
+        return parseError(&parser, parser.token.type == TOKEN_RPAREN ? "Unmatched ')'" : "Expected an operator");
+    }
+    return 0;
+}
+
+int findVariable(const Program* program, const char* name) {
+    for (int i = 0; i < program->varCount; i++) {
+        if (strcmp(program->names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void printProgram(const Program* program) {
+    for (size_t pc = 0; pc < program->length; pc++) {
+        uint8_t op = program->code[pc];
+        printf("%4zu  %-6s", pc, opNames[op]);
+        if (op == OP_CONST) {
+            printf(" %.17g", program->constants[program->code[++pc]]);
+        } else if (op == OP_VAR) {
+            printf(" %s", program->names[program->code[++pc]]);
+        }
+        printf("\n");
+    }
+    printf("%zu bytes, %d constants, stack depth %d\n", program->length, program->constantCount, program->maxStack);
+}
+
+// ---------------------------------------------------------------------------
+// Interpreter
+// ---------------------------------------------------------------------------
+
+// Run the program with vars[i] bound to the i-th variable. Division or
+// modulo by zero ORs EVAL_DIV_ZERO into *status (the result is then inf or
+// nan, as IEEE arithmetic gives).
+double runProgram(const Program* program, const double* vars, int* status) {
+    // One indirect jump per instruction (GNU C labels as values) instead of
+    // a loop around a switch: each handler jumps straight to the next one
+    static const void* handlers[OP_COUNT] = {
+        &&op_const, &&op_var, &&op_add, &&op_sub, &&op_mul, &&op_div, &&op_mod, &&op_pow, &&op_min, &&op_max,
+        &&op_unary, &&op_unary, &&op_unary, &&op_unary, &&op_unary, &&op_unary, &&op_unary, &&op_unary,
+    };
+    double stack[EXPR_MAX_STACK + 1];
+    double* top = stack;                    // stack[0] is a dummy below the bottom
+    stack[0] = 0;
+    const uint8_t* pc = program->code;
+    const uint8_t* end = pc + program->length;
+    const double* constants = program->constants;
+    int flags = 0;
+
+#define DISPATCH() if (pc == end) goto done; goto *handlers[*pc]
+#define BINARY(op) top[-1] = applyOperator(op, top[-1], top[0]); top--; pc++; DISPATCH()
+
+    DISPATCH();
+op_const:
+    *++top = constants[pc[1]];
+    pc += 2;
+    DISPATCH();
+op_var:
+    *++top = vars[pc[1]];
+    pc += 2;
+    DISPATCH();
+op_add:
+    BINARY(OP_ADD);
+op_sub:
+    BINARY(OP_SUB);
+op_mul:
+    BINARY(OP_MUL);
+op_div:
+    flags |= top[0] == 0;
+    BINARY(OP_DIV);
+op_mod:
+    flags |= top[0] == 0;
+    BINARY(OP_MOD);
+op_pow:
+    BINARY(OP_POW);
+op_min:
+    BINARY(OP_MIN);
+op_max:
+    BINARY(OP_MAX);
+op_unary:
+    top[0] = applyOperator(*pc++, top[0], 0);
+    DISPATCH();
+
+#undef BINARY
+#undef DISPATCH
+
+done:
+    if (flags) {
+        *status |= EVAL_DIV_ZERO;
+    }
+    return top[0];
+}
+
+// out[i] = the program over the i-th row of bindings (count rows of
+// varCount values each); returns the OR of the rows' status bits
+int runProgramRows(const Program* program, const double* bindings, size_t count, double* out) {
+    int status = 0;
+    size_t stride = (size_t)program->varCount;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = runProgram(program, bindings + i * stride, &status);
+    }
+    return status;
+}
+
+// ---------------------------------------------------------------------------
+// Column evaluation
+// ---------------------------------------------------------------------------
+
+// Evaluate the bytecode once per block of COLUMN_BLOCK rows instead of once
+// per row: every instruction becomes a plain loop over the block, which the
+// compiler turns into SIMD code, and dispatch costs 1/COLUMN_BLOCK per row.
+// A variable is a pointer into its column (no copy) and each stack slot owns
+// two block buffers, so an operator never writes over its own input and
+// all the loops can be restrict-qualified. Every loop runs exactly
+// COLUMN_BLOCK times (a short last block is padded), a trip count the
+// vectorizer handles even at -O2. The kernels are also built for AVX2,
+// picked at load time on CPUs that have it.
+
+__attribute__((target_clones("avx2", "default")))
+static void columnBinary(uint8_t op, double* restrict r, const double* restrict a, const double* restrict b,
+                         uint8_t* restrict status) {
+    size_t i;
+    switch (op) {
+        case OP_ADD: for (i = 0; i < COLUMN_BLOCK; i++) r[i] = applyOperator(OP_ADD, a[i], b[i]); break;
+        case OP_SUB: for (i = 0; i < COLUMN_BLOCK; i++) r[i] = applyOperator(OP_SUB, a[i], b[i]); break;
+        case OP_MUL: for (i = 0; i < COLUMN_BLOCK; i++) r[i] = applyOperator(OP_MUL, a[i], b[i]); break;
+        case OP_MIN: for (i = 0; i < COLUMN_BLOCK; i++) r[i] = applyOperator(OP_MIN, a[i], b[i]); break;
+        case OP_MAX: for (i = 0; i < COLUMN_BLOCK; i++) r[i] = applyOperator(OP_MAX, a[i], b[i]); break;
+        case OP_POW: for (i = 0; i < COLUMN_BLOCK; i++) r[i] = applyOperator(OP_POW, a[i], b[i]); break;
+        case OP_DIV:
+        case OP_MOD: {
+            // Zero divisors are rare: one vector pass finds out whether the
+            // block has any before the per-element mask is written
+            long zero = 0;
+            for (i = 0; i < COLUMN_BLOCK; i++) {
+                zero |= b[i] == 0;
+            }
+            if (op == OP_DIV) {
+                for (i = 0; i < COLUMN_BLOCK; i++) r[i] = applyOperator(OP_DIV, a[i], b[i]);
             } else {
-                printf("Error: Division by zero is not allowed!\n");
+                for (i = 0; i < COLUMN_BLOCK; i++) r[i] = applyOperator(OP_MOD, a[i], b[i]);
+            }
+            if (zero) {
+                for (i = 0; i < COLUMN_BLOCK; i++) {
+                    status[i] |= b[i] == 0 ? EVAL_DIV_ZERO : 0;
+                }
             }
             break;
-            
-        default:
-            printf("Error: Invalid operator!\n");
+        }
+    }
+}
+
+__attribute__((target_clones("avx2", "default")))
+static void columnUnary(uint8_t op, double* restrict r, const double* restrict a) {
+    size_t i;
+    switch (op) {
+        case OP_NEG: for (i = 0; i < COLUMN_BLOCK; i++) r[i] = applyOperator(OP_NEG, a[i], 0); break;
+        case OP_ABS: for (i = 0; i < COLUMN_BLOCK; i++) r[i] = applyOperator(OP_ABS, a[i], 0); break;
+        case OP_SQRT: for (i = 0; i < COLUMN_BLOCK; i++) r[i] = applyOperator(OP_SQRT, a[i], 0); break;
+        default: for (i = 0; i < COLUMN_BLOCK; i++) r[i] = applyOperator(op, a[i], 0); break;
+    }
+}
+
+// out[i] = the program with variable v bound to columns[v][i], for i < count.
+// status[i] gets the row's status bits (EVAL_DIV_ZERO), so a zero divisor
+// marks its row and the run goes on. Returns -1 if out of memory.
+int runProgramColumns(const Program* program, const double* const* columns, size_t count, double* out,
+                      uint8_t* status) {
+    size_t slots = (size_t)program->maxStack;
+    size_t constants = (size_t)program->constantCount;
+    size_t vars = (size_t)program->varCount;
+    // Stack buffers, constant blocks, padded variables, result and status
+    size_t doubles = (2 * slots + constants + vars + 1) * COLUMN_BLOCK;
+    double* buffers = aligned_alloc(64, doubles * sizeof(double) + COLUMN_BLOCK);
+    if (buffers == NULL) {
+        return -1;
+    }
+    double* constant_blocks = buffers + 2 * slots * COLUMN_BLOCK;
+    double* padded = constant_blocks + constants * COLUMN_BLOCK;
+    double* tail_out = padded + vars * COLUMN_BLOCK;
+    uint8_t* block_status = (uint8_t*)(tail_out + COLUMN_BLOCK);
+    for (size_t c = 0; c < constants; c++) {
+        for (size_t i = 0; i < COLUMN_BLOCK; i++) {
+            constant_blocks[c * COLUMN_BLOCK + i] = program->constants[c];
+        }
     }
-    
+
+    const double* stack[EXPR_MAX_STACK];
+    const double* block_columns[EXPR_MAX_VARS];
+    const uint8_t* code = program->code;
+    for (size_t start = 0; start < count; start += COLUMN_BLOCK) {
+        size_t n = count - start < COLUMN_BLOCK ? count - start : COLUMN_BLOCK;
+        double* block_out = out + start;
+        for (size_t v = 0; v < vars; v++) {
+            block_columns[v] = columns[v] + start;
+        }
+        if (n < COLUMN_BLOCK) {
+            // Pad the short last block with ones (harmless as divisors)
+            for (size_t v = 0; v < vars; v++) {
+                double* column = padded + v * COLUMN_BLOCK;
+                memcpy(column, columns[v] + start, n * sizeof(double));
+                for (size_t i = n; i < COLUMN_BLOCK; i++) {
+                    column[i] = 1;
+                }
+                block_columns[v] = column;
+            }
+            block_out = tail_out;
+        }
+        memset(block_status, 0, COLUMN_BLOCK);
+
+        int depth = 0;
+        for (size_t pc = 0; pc < program->length; pc++) {
+            uint8_t op = code[pc];
+            if (op == OP_CONST) {
+                stack[depth++] = constant_blocks + (size_t)code[++pc] * COLUMN_BLOCK;
+                continue;
+            }
+            if (op == OP_VAR) {
+                stack[depth++] = block_columns[code[++pc]];
+                continue;
+            }
+            // The result goes to its slot's buffer that is not an input, or
+            // straight to the output for the last instruction
+            int slot = op <= OP_MAX ? depth - 2 : depth - 1;
+            double* result = buffers + (size_t)2 * slot * COLUMN_BLOCK;
+            if (stack[slot] == result) {
+                result += COLUMN_BLOCK;
+            }
+            if (pc + 1 == program->length) {
+                result = block_out;
+            }
+            if (op <= OP_MAX) {
+                columnBinary(op, result, stack[slot], stack[slot + 1], block_status);
+            } else {
+                columnUnary(op, result, stack[slot]);
+            }
+            stack[slot] = result;
+            depth = slot + 1;
+        }
+        if (stack[0] != block_out) {
+            memcpy(block_out, stack[0], COLUMN_BLOCK * sizeof(double));     // A lone constant or variable
+        }
+        if (block_out != out + start) {
+            memcpy(out + start, block_out, n * sizeof(double));
+        }
+        memcpy(status + start, block_status, n);
+    }
+    free(buffers);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// JIT compiler (x86-64)
+// ---------------------------------------------------------------------------
+
+// Translate the bytecode into machine code for a column kernel
+//   void kernel(const double* const* columns, double* out, size_t count, uint8_t* status)
+// that handles two rows per iteration with packed SSE2 instructions (every
+// x86-64 CPU has them). Stack slot d lives in register xmm(d + 2), so an
+// expression runs with no loads or stores besides its inputs and output.
+// +, -, *, /, min, max, sqrt, abs and negation are single instructions;
+// the other functions are called per lane, with the live slots spilled to
+// the native stack around the call. The code is assembled into a malloc'd
+// buffer, then copied into an mmap'd one that is made executable only after
+// the copy (never writable and executable at once).
+//
+// Other architectures, and expressions needing more than JIT_MAX_STACK
+// slots, get no kernel and run on the column interpreter instead.
+
+#define JIT_MAX_STACK 14                    // xmm2 .. xmm15
+
+typedef void (*JitKernel)(const double* const* columns, double* out, size_t count, uint8_t* status);
+
+typedef struct {
+    JitKernel kernel;                       // NULL: use the interpreter
+    void* memory;
+    size_t size;
+} JitProgram;
+
+#if defined(__x86_64__)
+
+enum { RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7, R12 = 12, R13 = 13, R14 = 14, R15 = 15 };
+
+#define JIT_SPILL_BYTES (16 * JIT_MAX_STACK + 8)    // Keeps rsp 16-byte aligned at calls
+
+typedef struct {
+    uint8_t* bytes;
+    size_t length, capacity;
+    size_t fixups[EXPR_MAX_CODE];           // Where a rip-relative disp32 goes
+    size_t targets[EXPR_MAX_CODE];          // Which 16-byte data entry it points to
+    int fixupCount;
+    int failed;
+} Assembler;
+
+static void emit(Assembler* as, const uint8_t* bytes, size_t count) {
+    if (as->length + count > as->capacity) {
+        size_t capacity = as->capacity ? as->capacity * 2 : 4096;
+        uint8_t* grown = realloc(as->bytes, capacity);
+        if (grown == NULL) {
+            as->failed = 1;
+            return;
+        }
+        as->bytes = grown;
+        as->capacity = capacity;
+    }
+    memcpy(as->bytes + as->length, bytes, count);
+    as->length += count;
+}
+
+static void emit1(Assembler* as, uint8_t byte) {
+    emit(as, &byte, 1);
+}
+
+static void emit4(Assembler* as, uint32_t value) {
+    emit(as, (const uint8_t*)&value, 4);
+}
+
+// REX prefix for reg (ModRM.reg), index (SIB.index) and base (ModRM.rm or
+// SIB.base); emitted only when needed
+static void emitRex(Assembler* as, int wide, int reg, int index, int base) {
+    uint8_t rex = (uint8_t)(0x40 | (wide ? 8 : 0) | (reg & 8 ? 4 : 0) | (index >= 0 && (index & 8) ? 2 : 0) |
+                            (base & 8 ? 1 : 0));
+    if (rex != 0x40) {
+        emit1(as, rex);
+    }
+}
+
+// ModRM/SIB/displacement for [base + index << scale + disp] (index -1: none)
+static void emitAddress(Assembler* as, int reg, int base, int index, int scale, int32_t disp) {
+    int mod = disp == 0 && (base & 7) != RBP ? 0 : disp >= -128 && disp <= 127 ? 1 : 2;
+    if (index >= 0 || (base & 7) == RSP) {
+        emit1(as, (uint8_t)(mod << 6 | (reg & 7) << 3 | 4));
+        emit1(as, (uint8_t)(scale << 6 | (index >= 0 ? index & 7 : 4) << 3 | (base & 7)));
+    } else {
+        emit1(as, (uint8_t)(mod << 6 | (reg & 7) << 3 | (base & 7)));
+    }
+    if (mod == 1) {
+        emit1(as, (uint8_t)disp);
+    } else if (mod == 2) {
+        emit4(as, (uint32_t)disp);
+    }
+}
+
+// prefix 0F op with xmm registers dst, src
+static void emitSse(Assembler* as, uint8_t prefix, uint8_t op, int dst, int src) {
+    emit1(as, prefix);
+    emitRex(as, 0, dst, -1, src);
+    uint8_t bytes[3] = {0x0F, op, (uint8_t)(0xC0 | (dst & 7) << 3 | (src & 7))};
+    emit(as, bytes, 3);
+}
+
+// prefix 0F op with xmm register reg and a memory operand
+static void emitSseMemory(Assembler* as, uint8_t prefix, uint8_t op, int reg, int base, int index, int scale,
+                          int32_t disp) {
+    emit1(as, prefix);
+    emitRex(as, 0, reg, index, base);
+    emit1(as, 0x0F);
+    emit1(as, op);
+    emitAddress(as, reg, base, index, scale, disp);
+}
+
+// prefix 0F op with xmm register reg and data entry `entry` (rip-relative)
+static void emitSseData(Assembler* as, uint8_t op, int reg, size_t entry) {
+    emit1(as, 0x66);
+    emitRex(as, 0, reg, -1, 0);
+    uint8_t bytes[3] = {0x0F, op, (uint8_t)((reg & 7) << 3 | 5)};
+    emit(as, bytes, 3);
+    if (as->fixupCount < EXPR_MAX_CODE) {
+        as->fixups[as->fixupCount] = as->length;
+        as->targets[as->fixupCount++] = entry;
+    } else {
+        as->failed = 1;
+    }
+    emit4(as, 0);
+}
+
+#define SSE_LOAD 0x10                       // movupd / movsd xmm, m
+#define SSE_STORE 0x11                      // movupd / movsd m, xmm
+#define SSE_SQRT 0x51
+#define SSE_AND 0x54
+#define SSE_XOR 0x57
+#define SSE_CMP 0xC2
+#define PACKED 0x66
+#define SCALAR 0xF2
+
+static int xmmOfSlot(int slot) {
+    return slot + 2;
+}
+
+// Call fn(x) or fn(x, y) for both lanes of slot, with the other live slots
+// saved across the call (every xmm register is caller-saved)
+static void emitCall(Assembler* as, void* function, int slot, int arity, int depth) {
+    for (int d = 0; d < depth; d++) {
+        emitSseMemory(as, PACKED, SSE_STORE, xmmOfSlot(d), RSP, -1, 0, 16 * d);
+    }
+    for (int lane = 0; lane < 2; lane++) {
+        emitSseMemory(as, SCALAR, SSE_LOAD, 0, RSP, -1, 0, 16 * slot + 8 * lane);
+        if (arity == 2) {
+            emitSseMemory(as, SCALAR, SSE_LOAD, 1, RSP, -1, 0, 16 * (slot + 1) + 8 * lane);
+        }
+        uint64_t address = (uint64_t)(uintptr_t)function;
+        uint8_t load[2] = {0x48, 0xB8};     // mov rax, imm64
+        emit(as, load, 2);
+        emit(as, (const uint8_t*)&address, 8);
+        uint8_t call[2] = {0xFF, 0xD0};     // call rax
+        emit(as, call, 2);
+        emitSseMemory(as, SCALAR, SSE_STORE, 0, RSP, -1, 0, 16 * slot + 8 * lane);
+    }
+    for (int d = 0; d <= slot; d++) {
+        emitSseMemory(as, PACKED, SSE_LOAD, xmmOfSlot(d), RSP, -1, 0, 16 * d);
+    }
+}
+
+// ebp |= movmskpd(divisor == 0): one bit per lane
+static void emitZeroCheck(Assembler* as, int divisor) {
+    emitSse(as, PACKED, SSE_XOR, 0, 0);
+    emitSse(as, PACKED, SSE_CMP, 0, divisor);
+    emit1(as, 0x00);                        // Predicate: equal
+    emitSse(as, PACKED, 0x50, RAX, 0);      // movmskpd eax, xmm0
+    uint8_t merge[2] = {0x09, 0xC5};        // or ebp, eax
+    emit(as, merge, 2);
+}
+
+static void* libraryFunction(uint8_t op) {
+    switch (op) {
+        case OP_MOD: return (void*)fmod;
+        case OP_POW: return (void*)pow;
+        case OP_EXP: return (void*)exp;
+        case OP_LOG: return (void*)log;
+        case OP_SIN: return (void*)sin;
+        case OP_COS: return (void*)cos;
+        case OP_TAN: return (void*)tan;
+    }
+    return NULL;
+}
+
+// Data entries (16 bytes each): sign mask, magnitude mask, then constants
+#define DATA_SIGN 0
+#define DATA_MAGNITUDE 1
+#define DATA_CONSTANTS 2
+
+int jitCompile(const Program* program, JitProgram* jit) {
+    jit->kernel = NULL;
+    jit->memory = NULL;
+    jit->size = 0;
+    if (program->maxStack > JIT_MAX_STACK) {
+        return -1;
+    }
+    Assembler as = {0};
+    int divides = 0;
+    for (size_t pc = 0; pc < program->length; pc++) {
+        divides |= program->code[pc] == OP_DIV || program->code[pc] == OP_MOD;
+        pc += program->code[pc] == OP_CONST || program->code[pc] == OP_VAR;
+    }
+
+    // Prologue: save the callee-saved registers we use, reserve the spill
+    // area, move the arguments where calls cannot clobber them
+    static const uint8_t prologue[] = {
+        0x55, 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57,    // push rbp, rbx, r12-r15
+        0x48, 0x81, 0xEC,                                              // sub rsp, imm32
+    };
+    emit(&as, prologue, sizeof(prologue));
+    emit4(&as, JIT_SPILL_BYTES);
+    static const uint8_t arguments[] = {
+        0x49, 0x89, 0xFC,                   // mov r12, rdi (columns)
+        0x49, 0x89, 0xF5,                   // mov r13, rsi (out)
+        0x49, 0x89, 0xD6,                   // mov r14, rdx (count)
+        0x49, 0x89, 0xCF,                   // mov r15, rcx (status)
+        0x31, 0xDB,                         // xor ebx, ebx (row)
+        0x4D, 0x85, 0xF6,                   // test r14, r14
+        0x0F, 0x84,                         // jz epilogue (rel32 patched below)
+    };
+    emit(&as, arguments, sizeof(arguments));
+    size_t skip_loop = as.length;
+    emit4(&as, 0);
+
+    size_t loop_top = as.length;
+    if (divides) {
+        uint8_t clear[2] = {0x31, 0xED};    // xor ebp, ebp
+        emit(&as, clear, 2);
+    }
+    int depth = 0;
+    for (size_t pc = 0; pc < program->length; pc++) {
+        uint8_t op = program->code[pc];
+        if (op == OP_CONST) {
+            emitSseData(&as, SSE_LOAD, xmmOfSlot(depth++), DATA_CONSTANTS + program->code[++pc]);
+            continue;
+        }
+        if (op == OP_VAR) {
+            // mov rax, [r12 + 8 * v]; movupd xmm, [rax + rbx * 8]
+            emitRex(&as, 1, RAX, -1, R12);
+            emit1(&as, 0x8B);
+            emitAddress(&as, RAX, R12, -1, 0, 8 * program->code[++pc]);
+            emitSseMemory(&as, PACKED, SSE_LOAD, xmmOfSlot(depth++), RAX, RBX, 3, 0);
+            continue;
+        }
+        int slot = op <= OP_MAX ? depth - 2 : depth - 1;
+        int a = xmmOfSlot(slot), b = xmmOfSlot(slot + 1);
+        switch (op) {
+            case OP_ADD: emitSse(&as, PACKED, 0x58, a, b); break;
+            case OP_MUL: emitSse(&as, PACKED, 0x59, a, b); break;
+            case OP_SUB: emitSse(&as, PACKED, 0x5C, a, b); break;
+            case OP_MIN: emitSse(&as, PACKED, 0x5D, a, b); break;  // a < b ? a : b, like applyOperator
+            case OP_MAX: emitSse(&as, PACKED, 0x5F, a, b); break;
+            case OP_DIV: emitZeroCheck(&as, b); emitSse(&as, PACKED, 0x5E, a, b); break;
+            case OP_MOD: emitZeroCheck(&as, b); emitCall(&as, libraryFunction(op), slot, 2, depth); break;
+            case OP_POW: emitCall(&as, libraryFunction(op), slot, 2, depth); break;
+            case OP_NEG: emitSseData(&as, SSE_XOR, a, DATA_SIGN); break;
+            case OP_ABS: emitSseData(&as, SSE_AND, a, DATA_MAGNITUDE); break;
+            case OP_SQRT: emitSse(&as, PACKED, SSE_SQRT, a, a); break;
+            default: emitCall(&as, libraryFunction(op), slot, 1, depth); break;
+        }
+        depth = slot + 1;
+    }
+
+    // movupd [r13 + rbx * 8], xmm2
+    emitSseMemory(&as, PACKED, SSE_STORE, xmmOfSlot(0), R13, RBX, 3, 0);
+    if (divides) {
+        // Lane bits 0 and 1 of ebp become status bytes: word [r15 + rbx]
+        static const uint8_t status[] = {
+            0x89, 0xE8, 0x83, 0xE0, 0x01,   // mov eax, ebp; and eax, 1
+            0x89, 0xE9, 0x83, 0xE1, 0x02,   // mov ecx, ebp; and ecx, 2
+            0xC1, 0xE1, 0x07, 0x09, 0xC8,   // shl ecx, 7; or eax, ecx
+            0x66, 0x41, 0x89, 0x04, 0x1F,   // mov [r15 + rbx], ax
+        };
+        emit(&as, status, sizeof(status));
+    }
+    static const uint8_t next[] = {
+        0x48, 0x83, 0xC3, 0x02,             // add rbx, 2
+        0x4C, 0x39, 0xF3,                   // cmp rbx, r14
+        0x0F, 0x82,                         // jb loop_top
+    };
+    emit(&as, next, sizeof(next));
+    emit4(&as, (uint32_t)(int32_t)(loop_top - (as.length + 4)));
+    size_t epilogue = as.length;
+    static const uint8_t restore[] = {
+        0x48, 0x81, 0xC4,                   // add rsp, imm32
+    };
+    emit(&as, restore, sizeof(restore));
+    emit4(&as, JIT_SPILL_BYTES);
+    static const uint8_t pops[] = {
+        0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0x5D,    // pop r15-r12, rbx, rbp
+        0xC3,                                                          // ret
+    };
+    emit(&as, pops, sizeof(pops));
+
+    // Data: 16-byte aligned entries after the code, then the fixups
+    while (as.length % 16 != 0) {
+        emit1(&as, 0xCC);
+    }
+    size_t data = as.length;
+    uint64_t masks[4] = {0x8000000000000000ULL, 0x8000000000000000ULL, 0x7FFFFFFFFFFFFFFFULL,
+                         0x7FFFFFFFFFFFFFFFULL};
+    emit(&as, (const uint8_t*)masks, sizeof(masks));
+    for (int c = 0; c < program->constantCount; c++) {
+        double pair[2] = {program->constants[c], program->constants[c]};
+        emit(&as, (const uint8_t*)pair, sizeof(pair));
+    }
+    if (as.failed) {
+        free(as.bytes);
+        return -1;
+    }
+    int32_t skip = (int32_t)(epilogue - (skip_loop + 4));
+    memcpy(as.bytes + skip_loop, &skip, 4);
+    for (int f = 0; f < as.fixupCount; f++) {
+        int32_t disp = (int32_t)(data + 16 * as.targets[f] - (as.fixups[f] + 4));
+        memcpy(as.bytes + as.fixups[f], &disp, 4);
+    }
+
+    void* memory = mmap(NULL, as.length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        free(as.bytes);
+        return -1;
+    }
+    memcpy(memory, as.bytes, as.length);
+    free(as.bytes);
+    if (mprotect(memory, as.length, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, as.length);
+        return -1;
+    }
+    jit->memory = memory;
+    jit->size = as.length;
+    jit->kernel = (JitKernel)memory;
+    return 0;
+}
+
+#else
+
+int jitCompile(const Program* program, JitProgram* jit) {
+    (void)program;
+    jit->kernel = NULL;
+    jit->memory = NULL;
+    jit->size = 0;
+    return -1;
+}
+
+#endif
+
+void jitFree(JitProgram* jit) {
+    if (jit->memory != NULL) {
+        munmap(jit->memory, jit->size);
+    }
+    jit->kernel = NULL;
+    jit->memory = NULL;
+}
+
+// Same contract as runProgramColumns: the JIT kernel takes the rows in
+// pairs and an odd last row goes through the interpreter. Without a kernel
+// everything goes through the column interpreter.
+int runProgramJit(const JitProgram* jit, const Program* program, const double* const* columns, size_t count,
+                  double* out, uint8_t* status) {
+    if (jit->kernel == NULL) {
+        return runProgramColumns(program, columns, count, out, status);
+    }
+    size_t even = count & ~(size_t)1;
+    memset(status, 0, count);
+    jit->kernel(columns, out, even, status);
+    if (even < count) {
+        double vars[EXPR_MAX_VARS];
+        int flags = 0;
+        for (int v = 0; v < program->varCount; v++) {
+            vars[v] = columns[v][even];
+        }
+        out[even] = runProgram(program, vars, &flags);
+        status[even] = (uint8_t)flags;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Column input
+// ---------------------------------------------------------------------------
+
+// Columns loaded from a file, either owned arrays (CSV) or pointers into a
+// mapping (binary)
+typedef struct {
+    char names[EXPR_MAX_VARS][EXPR_MAX_NAME];
+    double* data[EXPR_MAX_VARS];
+    int count;
+    size_t rows;
+    void* mapping;
+    size_t mappingSize;
+} ColumnSet;
+
+static void freeColumnSet(ColumnSet* set) {
+    if (set->mapping != NULL) {
+        munmap(set->mapping, set->mappingSize);
+    } else {
+        for (int c = 0; c < set->count; c++) {
+            free(set->data[c]);
+        }
+    }
+}
+
+// Split a comma-separated list of names into set->names
+static int parseColumnNames(ColumnSet* set, const char* list) {
+    set->count = 0;
+    while (*list != '\0') {
+        size_t length = strcspn(list, ",");
+        while (length > 0 && charIsSpace(list[length - 1])) {
+            length--;
+        }
+        if (set->count == EXPR_MAX_VARS || length == 0 || length >= EXPR_MAX_NAME) {
+            printf("Error: Expected up to %d comma-separated column names\n", EXPR_MAX_VARS);
+            return -1;
+        }
+        memcpy(set->names[set->count], list, length);
+        set->names[set->count++][length] = '\0';
+        list += strcspn(list, ",");
+        if (*list == ',') {
+            list++;
+        }
+        while (charIsSpace(*list)) {
+            list++;
+        }
+    }
+    return 0;
+}
+
+// CSV: a header line of column names, then one row of numbers per line
+static int loadCsvColumns(const char* path, ColumnSet* set) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        printf("Error: Cannot open %s\n", path);
+        return -1;
+    }
+    char line[4096];
+    if (fgets(line, sizeof(line), file) == NULL) {
+        printf("Error: %s is empty\n", path);
+        fclose(file);
+        return -1;
+    }
+    line[strcspn(line, "\r\n")] = '\0';
+    if (parseColumnNames(set, line) != 0) {
+        fclose(file);
+        return -1;
+    }
+    size_t capacity = 0;
+    set->rows = 0;
+    set->mapping = NULL;
+    for (int c = 0; c < set->count; c++) {
+        set->data[c] = NULL;
+    }
+    int result = 0;
+    while (result == 0 && fgets(line, sizeof(line), file) != NULL) {
+        if (line[strspn(line, " \t\r\n")] == '\0') {
+            continue;
+        }
+        if (set->rows == capacity) {
+            capacity = capacity ? capacity * 2 : 4096;
+            for (int c = 0; c < set->count && result == 0; c++) {
+                double* grown = realloc(set->data[c], capacity * sizeof(double));
+                if (grown == NULL) {
+                    printf("Error: Out of memory\n");
+                    result = -1;
+                } else {
+                    set->data[c] = grown;
+                }
+            }
+        }
+        char* cursor = line;
+        for (int c = 0; c < set->count && result == 0; c++) {
+            char* end;
+            set->data[c][set->rows] = strtod(cursor, &end);
+            while (charIsSpace(*end)) {
+                end++;
+            }
+            if (end == cursor || (*end != (c + 1 < set->count ? ',' : '\0'))) {
+                printf("Error: Bad number in row %zu, column %s of %s\n", set->rows + 1, set->names[c], path);
+                result = -1;
+            }
+            cursor = end + 1;
+        }
+        set->rows++;
+    }
+    fclose(file);
+    if (result != 0) {
+        freeColumnSet(set);
+    }
+    return result;
+}
+
+// Binary: column-major doubles (all of the first column, then the second,
+// ...) in the machine's byte order, mapped without copying
+static int loadBinaryColumns(const char* path, ColumnSet* set) {
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        printf("Error: Cannot open %s\n", path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    size_t size = (size_t)info.st_size;
+    size_t row_bytes = (size_t)set->count * sizeof(double);
+    if (size == 0 || size % row_bytes != 0) {
+        printf("Error: %s does not hold %d whole columns of doubles\n", path, set->count);
+        close(fd);
+        return -1;
+    }
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        printf("Error: Cannot map %s\n", path);
+        return -1;
+    }
+    set->mapping = mapping;
+    set->mappingSize = size;
+    set->rows = size / row_bytes;
+    for (int c = 0; c < set->count; c++) {
+        set->data[c] = (double*)mapping + (size_t)c * set->rows;
+    }
+    return 0;
+}
+
+static int endsWith(const char* text, const char* suffix) {
+    size_t length = strlen(text), suffix_length = strlen(suffix);
+    return length >= suffix_length && strcmp(text + length - suffix_length, suffix) == 0;
+}
+
+// --columns EXPR FILE [--names a,b,...] [--out FILE] [--jit]
+static int evaluateColumnsFile(int argc, char* argv[]) {
+    Program program;
+    ColumnSet set = {0};
+    const char* names = NULL;
+    const char* out_path = NULL;
+    int use_jit = 0;
+    for (int i = 4; i < argc; i++) {
+        if (strcmp(argv[i], "--names") == 0 && i + 1 < argc) {
+            names = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "--jit") == 0) {
+            use_jit = 1;
+        }
+    }
+    if (compileExpression(argv[2], &program) != 0) {
+        printf("Error: %s\n", program.error);
+        return 1;
+    }
+    const char* path = argv[3];
+    int loaded;
+    if (endsWith(path, ".csv")) {
+        loaded = loadCsvColumns(path, &set);
+    } else {
+        // Binary columns are named by --names, or are the expression's
+        // variables in order of appearance
+        if (names != NULL) {
+            loaded = parseColumnNames(&set, names);
+        } else {
+            set.count = program.varCount;
+            memcpy(set.names, program.names, sizeof(set.names));
+            loaded = set.count > 0 ? 0 : -1;
+            if (loaded != 0) {
+                printf("Error: The expression has no variables to bind to columns\n");
+            }
+        }
+        loaded = loaded == 0 ? loadBinaryColumns(path, &set) : -1;
+    }
+    if (loaded != 0) {
+        return 1;
+    }
+
+    // Line the program's variables up with the file's columns
+    const double* columns[EXPR_MAX_VARS];
+    for (int v = 0; v < program.varCount; v++) {
+        int found = -1;
+        for (int c = 0; c < set.count; c++) {
+            if (strcmp(set.names[c], program.names[v]) == 0) {
+                found = c;
+            }
+        }
+        if (found < 0) {
+            printf("Error: Column '%s' not found in %s\n", program.names[v], path);
+            freeColumnSet(&set);
+            return 1;
+        }
+        columns[v] = set.data[found];
+    }
+
+    size_t rows = set.rows;
+    double* out = malloc((rows ? rows : 1) * sizeof(double));
+    uint8_t* status = malloc(rows ? rows : 1);
+    if (out == NULL || status == NULL) {
+        printf("Error: Out of memory\n");
+        free(out);
+        free(status);
+        freeColumnSet(&set);
+        return 1;
+    }
+    JitProgram jit = {0};
+    if (use_jit && jitCompile(&program, &jit) != 0) {
+        printf("Note: No JIT for this expression or machine, using the interpreter\n");
+    }
+    double start = nowSeconds();
+    if (runProgramJit(&jit, &program, columns, rows, out, status) != 0) {
+        printf("Error: Out of memory\n");
+        jitFree(&jit);
+        free(out);
+        free(status);
+        freeColumnSet(&set);
+        return 1;
+    }
+    double seconds = nowSeconds() - start;
+    jitFree(&jit);
+
+    size_t flagged = 0;
+    double sum = 0;
+    for (size_t i = 0; i < rows; i++) {
+        if (status[i] & EVAL_DIV_ZERO) {
+            if (flagged < 5) {
+                printf("Row %zu: Division by zero\n", i + 1);
+            }
+            flagged++;
+        } else {
+            sum += out[i];
+        }
+    }
+    printf("%zu rows in %.3f s (%.1f M rows/s), %zu with a division by zero, sum of the rest = %.15g\n", rows,
+           seconds, rows / (seconds > 0 ? seconds : 1e-9) / 1e6, flagged, sum);
+
+    if (out_path != NULL) {
+        FILE* file = fopen(out_path, endsWith(out_path, ".csv") ? "w" : "wb");
+        if (file == NULL) {
+            printf("Error: Cannot create %s\n", out_path);
+        } else if (endsWith(out_path, ".csv")) {
+            fprintf(file, "result,div_zero\n");
+            for (size_t i = 0; i < rows; i++) {
+                fprintf(file, "%.17g,%d\n", out[i], status[i] & EVAL_DIV_ZERO ? 1 : 0);
+            }
+            fclose(file);
+        } else {
+            fwrite(out, sizeof(double), rows, file);
+            fclose(file);
+        }
+    }
+    free(out);
+    free(status);
+    freeColumnSet(&set);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------
+
+static const char* benchExpressions[] = {
+    "x * x + 3 * x - 7",
+    "sqrt(x * x + y * y) / (1 + 2 * 3)",
+    "(x + y) * (x - y) / (z + 0.5) + 2 ^ 10 - sin(pi / 6) * 4",
+};
+
+static void benchmarkCalculator(double millions) {
+    size_t rows = (size_t)(millions * 1e6);
+    size_t reparse_rows = rows / 20 > 0 ? rows / 20 : 1;
+    double* bindings = malloc(rows * 3 * sizeof(double));
+    double* out = malloc(rows * sizeof(double));
+    if (bindings == NULL || out == NULL) {
+        printf("Error: Out of memory\n");
+        free(bindings);
+        free(out);
+        return;
+    }
+    uint64_t state = 88172645463325252ULL;
+    for (size_t i = 0; i < rows * 3; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        bindings[i] = (double)(state >> 11) / 9007199254740992.0 * 200 - 100;
+    }
+
+    printf("%zu rows per compiled run, %zu per re-parsed run\n", rows, reparse_rows);
+    printf("%-58s %12s %12s %9s\n", "expression", "compiled", "re-parsed", "speedup");
+    for (size_t e = 0; e < sizeof(benchExpressions) / sizeof(benchExpressions[0]); e++) {
+        Program program;
+        double start = nowSeconds();
+        if (compileExpression(benchExpressions[e], &program) != 0) {
+            printf("Error: %s\n", program.error);
+            continue;
+        }
+        runProgramRows(&program, bindings, rows, out);
+        double compiled = rows / (nowSeconds() - start);
+        int stride = program.varCount;
+
+        // Re-parse: compile the text again for every row
+        int mismatches = 0;
+        start = nowSeconds();
+        for (size_t i = 0; i < reparse_rows; i++) {
+            Program again;
+            int status = 0;
+            compileExpression(benchExpressions[e], &again);
+            double value = runProgram(&again, bindings + i * (size_t)stride, &status);
+            mismatches += value != out[i];
+        }
+        double reparsed = reparse_rows / (nowSeconds() - start);
+        printf("%-58s %8.1f M/s %8.2f M/s %8.1fx%s\n", benchExpressions[e], compiled / 1e6, reparsed / 1e6,
+               compiled / reparsed, mismatches ? "  MISMATCH" : "");
+    }
+    free(bindings);
+    free(out);
+}
+
+// Row-at-a-time interpreter against column blocks on the same data
+static void benchmarkColumns(double millions) {
+    size_t rows = (size_t)(millions * 1e6);
+    double* bindings = malloc(rows * 3 * sizeof(double));
+    double* column_data = malloc(rows * 3 * sizeof(double));
+    double* row_out = malloc(rows * sizeof(double));
+    double* column_out = malloc(rows * sizeof(double));
+    uint8_t* status = malloc(rows);
+    if (bindings == NULL || column_data == NULL || row_out == NULL || column_out == NULL || status == NULL) {
+        printf("Error: Out of memory\n");
+        free(bindings);
+        free(column_data);
+        free(row_out);
+        free(column_out);
+        free(status);
+        return;
+    }
+    uint64_t state = 88172645463325252ULL;
+    for (size_t i = 0; i < rows * 3; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        bindings[i] = (double)(state >> 11) / 9007199254740992.0 * 200 - 100;
+        if (i % 3 == 1 && i % 3001 == 1) {
+            bindings[i] = 0;                // y is sometimes zero
+        }
+    }
+    for (size_t i = 0; i < rows; i++) {
+        for (int c = 0; c < 3; c++) {
+            column_data[(size_t)c * rows + i] = bindings[i * 3 + c];
+        }
+    }
+    memset(row_out, 0, rows * sizeof(double));     // Fault the pages in before timing
+    memset(column_out, 0, rows * sizeof(double));
+    memset(status, 0, rows);
+
+    static const char* expressions[] = {
+        "x * x + 3 * x - 7",
+        "sqrt(x * x + y * y) / (1 + 2 * 3)",
+        "(x + y) * (x - y) / (z + 0.5) + 2 ^ 10 - sin(pi / 6) * 4",
+        "x / y + z",
+    };
+    printf("%zu rows, blocks of %d\n", rows, COLUMN_BLOCK);
+    printf("%-58s %12s %12s %9s %9s\n", "expression", "row", "column", "speedup", "div by 0");
+    for (size_t e = 0; e < sizeof(expressions) / sizeof(expressions[0]); e++) {
+        Program program;
+        if (compileExpression(expressions[e], &program) != 0) {
+            printf("Error: %s\n", program.error);
+            continue;
+        }
+        // Every expression names its variables in the order x, y, z, which
+        // is also the order of the values in a row
+        const double* columns[EXPR_MAX_VARS];
+        for (int v = 0; v < program.varCount; v++) {
+            columns[v] = column_data + (size_t)v * rows;
+        }
+        // Best of three runs each
+        double row_rate = 0, column_rate = 0;
+        for (int run = 0; run < 3; run++) {
+            int row_status = 0;
+            double start = nowSeconds();
+            for (size_t i = 0; i < rows; i++) {
+                row_out[i] = runProgram(&program, bindings + i * 3, &row_status);
+            }
+            double rate = rows / (nowSeconds() - start);
+            row_rate = rate > row_rate ? rate : row_rate;
+
+            start = nowSeconds();
+            runProgramColumns(&program, columns, rows, column_out, status);
+            rate = rows / (nowSeconds() - start);
+            column_rate = rate > column_rate ? rate : column_rate;
+        }
+
+        size_t mismatches = 0, flagged = 0;
+        for (size_t i = 0; i < rows; i++) {
+            int same = row_out[i] == column_out[i] || (row_out[i] != row_out[i] && column_out[i] != column_out[i]);
+            mismatches += !same;
+            flagged += (status[i] & EVAL_DIV_ZERO) != 0;
+        }
+        printf("%-58s %8.1f M/s %8.1f M/s %8.1fx %9zu%s\n", expressions[e], row_rate / 1e6, column_rate / 1e6,
+               column_rate / row_rate, flagged, mismatches ? "  MISMATCH" : "");
+    }
+    free(bindings);
+    free(column_data);
+    free(row_out);
+    free(column_out);
+    free(status);
+}
+
+// The benchmark expressions written directly in C, for the JIT benchmark
+static void nativeQuadratic(const double* const* c, double* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = c[0][i] * c[0][i] + 3 * c[0][i] - 7;
+    }
+}
+
+static void nativeHypot(const double* const* c, double* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = sqrt(c[0][i] * c[0][i] + c[1][i] * c[1][i]) / 7;
+    }
+}
+
+static void nativeMixed(const double* const* c, double* out, size_t count) {
+    double offset = 1024 - sin(M_PI / 6) * 4;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (c[0][i] + c[1][i]) * (c[0][i] - c[1][i]) / (c[2][i] + 0.5) + offset;
+    }
+}
+
+static void nativeRatio(const double* const* c, double* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = c[0][i] / c[1][i] + c[2][i];
+    }
+}
+
+static void nativeCalls(const double* const* c, double* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = exp(c[0][i] / 50) + fabs(c[1][i]) - (c[0][i] < c[2][i] ? c[0][i] : c[2][i]);
+    }
+}
+
+// Row and column interpreters, JIT and the same formula compiled as C, on
+// the same data
+static void benchmarkJit(double millions) {
+    static const struct {
+        const char* text;
+        void (*native)(const double* const* columns, double* out, size_t count);
+    } expressions[] = {
+        {"x * x + 3 * x - 7", nativeQuadratic},
+        {"sqrt(x * x + y * y) / (1 + 2 * 3)", nativeHypot},
+        {"(x + y) * (x - y) / (z + 0.5) + 2 ^ 10 - sin(pi / 6) * 4", nativeMixed},
+        {"x / y + z", nativeRatio},
+        {"exp(x / 50) + abs(y) - min(x, z)", nativeCalls},
+    };
+    size_t rows = (size_t)(millions * 1e6) | 1;    // Odd, so the interpreter finishes the last row
+    double* column_data = malloc(rows * 3 * sizeof(double));
+    double* column_out = malloc(rows * sizeof(double));
+    double* jit_out = malloc(rows * sizeof(double));
+    double* native_out = malloc(rows * sizeof(double));
+    uint8_t* status = malloc(rows);
+    uint8_t* jit_status = malloc(rows);
+    if (column_data == NULL || column_out == NULL || jit_out == NULL || native_out == NULL || status == NULL ||
+        jit_status == NULL) {
+        printf("Error: Out of memory\n");
+        free(column_data);
+        free(column_out);
+        free(jit_out);
+        free(native_out);
+        free(status);
+        free(jit_status);
+        return;
+    }
+    uint64_t state = 88172645463325252ULL;
+    for (size_t i = 0; i < rows * 3; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        column_data[i] = (double)(state >> 11) / 9007199254740992.0 * 200 - 100;
+        if (i >= rows && i < 2 * rows && i % 3001 == 0) {
+            column_data[i] = 0;             // y is sometimes zero
+        }
+    }
+    memset(column_out, 0, rows * sizeof(double));  // Fault the pages in before timing
+    memset(jit_out, 0, rows * sizeof(double));
+    memset(native_out, 0, rows * sizeof(double));
+
+    const double* columns[EXPR_MAX_VARS];
+    for (int v = 0; v < 3; v++) {
+        columns[v] = column_data + (size_t)v * rows;
+    }
+    printf("%zu rows\n", rows);
+    printf("%-58s %12s %12s %12s %12s %4s\n", "expression", "row", "column", "JIT", "native C", "JIT");
+    for (size_t e = 0; e < sizeof(expressions) / sizeof(expressions[0]); e++) {
+        Program program;
+        JitProgram jit;
+        if (compileExpression(expressions[e].text, &program) != 0) {
+            printf("Error: %s\n", program.error);
+            continue;
+        }
+        int compiled = jitCompile(&program, &jit) == 0;
+
+        // Best of three runs each
+        double row_rate = 0, column_rate = 0, jit_rate = 0, native_rate = 0;
+        for (int run = 0; run < 3; run++) {
+            int row_status = 0;
+            double start = nowSeconds();
+            for (size_t i = 0; i < rows; i++) {
+                double vars[3] = {columns[0][i], columns[1][i], columns[2][i]};
+                native_out[i] = runProgram(&program, vars, &row_status);
+            }
+            double rate = rows / (nowSeconds() - start);
+            row_rate = rate > row_rate ? rate : row_rate;
+
+            start = nowSeconds();
+            runProgramColumns(&program, columns, rows, column_out, status);
+            rate = rows / (nowSeconds() - start);
+            column_rate = rate > column_rate ? rate : column_rate;
+
+            start = nowSeconds();
+            runProgramJit(&jit, &program, columns, rows, jit_out, jit_status);
+            rate = rows / (nowSeconds() - start);
+            jit_rate = rate > jit_rate ? rate : jit_rate;
+
+            start = nowSeconds();
+            expressions[e].native(columns, native_out, rows);
+            rate = rows / (nowSeconds() - start);
+            native_rate = rate > native_rate ? rate : native_rate;
+        }
+
+        // The JIT must agree with the interpreter bit for bit; C may fold
+        // or contract differently, so it only has to be close
+        size_t mismatches = 0;
+        for (size_t i = 0; i < rows; i++) {
+            int same = memcmp(&column_out[i], &jit_out[i], sizeof(double)) == 0 || (column_out[i] != column_out[i] &&
+                                                                                   jit_out[i] != jit_out[i]);
+            double error = fabs(native_out[i] - column_out[i]);
+            mismatches += !same || status[i] != jit_status[i] || error > 1e-9 * (1 + fabs(column_out[i]));
+        }
+        printf("%-58s %8.1f M/s %8.1f M/s %8.1f M/s %8.1f M/s %4s%s\n", expressions[e].text, row_rate / 1e6,
+               column_rate / 1e6, jit_rate / 1e6, native_rate / 1e6, compiled ? "yes" : "no",
+               mismatches ? "  MISMATCH" : "");
+        jitFree(&jit);
+    }
+    free(column_data);
+    free(column_out);
+    free(jit_out);
+    free(native_out);
+    free(status);
+    free(jit_status);
+}
+
+// ---------------------------------------------------------------------------
+// Main
+// ---------------------------------------------------------------------------
+
+static void printResult(double result, int status) {
+    if (status & EVAL_DIV_ZERO) {
+        printf("Error: Division by zero is not allowed!\n");
+    } else {
+        printf("= %.15g\n", result);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Program program;
+
+    if (argc >= 3 && (strcmp(argv[1], "--eval") == 0 || strcmp(argv[1], "--disasm") == 0)) {
+        if (compileExpression(argv[2], &program) != 0) {
+            printf("Error: %s\n", program.error);
+            return 1;
+        }
+        if (strcmp(argv[1], "--disasm") == 0) {
+            printProgram(&program);
+            return 0;
+        }
+        double vars[EXPR_MAX_VARS] = {0};
+        for (int i = 3; i < argc; i++) {
+            char* equals = strchr(argv[i], '=');
+            if (equals == NULL) {
+                printf("Error: Expected name=value, got '%s'\n", argv[i]);
+                return 1;
+            }
+            *equals = '\0';
+            int index = findVariable(&program, argv[i]);
+            if (index >= 0) {
+                vars[index] = strtod(equals + 1, NULL);
+            }
+        }
+        int status = 0;
+        double result = runProgram(&program, vars, &status);
+        printResult(result, status);
+        return status ? 1 : 0;
+    }
+    if (argc >= 4 && strcmp(argv[1], "--columns") == 0) {
+        return evaluateColumnsFile(argc, argv);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        benchmarkCalculator(argc >= 3 ? atof(argv[2]) : 10);
+        return 0;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench-columns") == 0) {
+        benchmarkColumns(argc >= 3 ? atof(argv[2]) : 10);
+        return 0;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench-jit") == 0) {
+        benchmarkJit(argc >= 3 ? atof(argv[2]) : 10);
+        return 0;
+    }
+
+    char line[1024];
+    printf("=== Basic Calculator ===\n");
+    printf("Enter an expression (e.g. 2 * (3 + 4) or x ^ 2 + 1): ");
+    if (fgets(line, sizeof(line), stdin) == NULL) {
+        printf("Error: No expression given\n");
+        return 1;
+    }
+    line[strcspn(line, "\n")] = '\0';
+
+    if (compileExpression(line, &program) != 0) {
+        printf("Error: %s\n", program.error);
+        return 1;
+    }
+    double vars[EXPR_MAX_VARS];
+    for (int i = 0; i < program.varCount; i++) {
+        printf("Enter a value for %s: ", program.names[i]);
+        if (scanf("%lf", &vars[i]) != 1) {
+            printf("Error: Invalid number!\n");
+            return 1;
+        }
+    }
+    int status = 0;
+    double result = runProgram(&program, vars, &status);
+    printf("%s ", line);
+    printResult(result, status);
+
     return 0;
 }
@@ -6,36 +6,1017 @@
  * 
  * Features:
  * - Handles numbers less than 2
- * - Efficiently checks for primality using a loop
+ * - Any 64-bit input: isPrime64() divides out the primes below 100 (by
+ *   multiplying with their inverses mod 2^64), then runs Miller-Rabin with
+ *   a base set proven exact below 2^32 (2, 7, 61) or 2^64 (seven bases), on
+ *   Montgomery representatives so every step is a 64x64->128 multiply
+ * - isPrime64Batch() runs four numbers through each round side by side
+ * - Segmented sieve of Eratosthenes for bulk work: counting primes in a
+ *   range, visiting them in order, and answering many membership queries
+ *   at once. Numbers are stored on a mod-30 wheel (one byte covers 30
+ *   numbers, one bit per residue coprime to 30), segments are 32 KB so they
+ *   stay in L1, and segments are shared out between threads.
  * 
  * Usage: Compile and run the program
  * Example: gcc basic_PrimeChecker.c -o basic_PrimeChecker && ./basic_PrimeChecker
+ *   ./basic_PrimeChecker --count LO HI [THREADS]   primes in [LO, HI)
+ *   ./basic_PrimeChecker --list LO HI              print primes in [LO, HI)
+ *   ./basic_PrimeChecker --bench [LIMIT] [THREADS] numbers/sec for counting,
+ *                                                  bulk queries and trial division
+ *   ./basic_PrimeChecker --validate [LIMIT]        isPrime64 vs the sieve for all n < LIMIT
+ *   ./basic_PrimeChecker --bench-mr [COUNT]        numbers/sec on random 64-bit values
+ *   (build with -pthread; ranges go up to 10^13)
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
 
-int main() {
-    int n, i, isPrime = 1;
+// ---------------------------------------------------------------------------
+// Segmented mod-30 wheel sieve
+// ---------------------------------------------------------------------------
 
-    printf("Enter a positive integer: ");
-    scanf("%d", &n);
+#define SIEVE_SEGMENT_BYTES 32768                   // 983040 numbers per segment
+#define SIEVE_SEGMENT_SPAN ((uint64_t)SIEVE_SEGMENT_BYTES * 30)
+#define SIEVE_MAX_LIMIT 10000000000000ULL           // 10^13
+#define SIEVE_MAX_THREADS 64
+
+// Residues coprime to 30; bit i of a byte stands for 30 * byte + wheelResidues[i]
+static const uint8_t wheelResidues[8] = {1, 7, 11, 13, 17, 19, 23, 29};
+
+// Bit for each n % 30, or 0 for residues sharing a factor with 30
+static const uint8_t wheelBit[30] = {
+    0, 0x01, 0, 0, 0, 0, 0, 0x02, 0, 0, 0, 0x04, 0, 0x08, 0,
+    0, 0, 0x10, 0, 0x20, 0, 0, 0, 0x40, 0, 0, 0, 0, 0, 0x80,
+};
+
+// Primes 7 <= p <= sqrt(limit), and for each prime and each multiplier
+// class the bit its multiples land on (a multiple p * m with m = r mod 30
+// always has the same residue, and the next one in that class is 30p
+// later, i.e. p bytes on)
+typedef struct {
+    uint32_t* primes;
+    uint8_t* masks;          // masks[i * 8 + j]: bit of p_i * (30k + wheelResidues[j])
+    size_t count;
+    uint64_t limit;          // Good for sieving numbers below this
+} BasePrimes;
+
+// Per-thread crossing-off state: next[i * 8 + j] is the byte holding the
+// next multiple of primes[i] in class j
+typedef struct {
+    const BasePrimes* base;
+    uint64_t* next;
+    uint64_t byte;           // First byte of the next segment to sieve
+} SieveCursor;
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t isqrt64(uint64_t n) {
+    uint64_t r = 0;
+    for (uint64_t bit = 1ULL << 62; bit != 0; bit >>= 2) {
+        if (n >= r + bit) {
+            n -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+    }
+    return r;
+}
+
+static void freeBasePrimes(BasePrimes* base) {
+    free(base->primes);
+    free(base->masks);
+    memset(base, 0, sizeof(*base));
+}
+
+// Base primes for sieving everything below `limit`, by a plain sieve
+static int initBasePrimes(BasePrimes* base, uint64_t limit) {
+    memset(base, 0, sizeof(*base));
+    uint64_t root = isqrt64(limit) + 1;
+    unsigned char* composite = calloc(root + 1, 1);
+    if (composite == NULL) {
+        return -1;
+    }
+    size_t count = 0;
+    for (uint64_t i = 2; i <= root; i++) {
+        if (!composite[i]) {
+            if (i >= 7) {
+                count++;
+            }
+            for (uint64_t j = i * i; j <= root; j += i) {
+                composite[j] = 1;
+            }
+        }
+    }
+    base->primes = malloc((count + 1) * sizeof(uint32_t));
+    base->masks = malloc((count + 1) * 8);
+    if (base->primes == NULL || base->masks == NULL) {
+        free(composite);
+        freeBasePrimes(base);
+        return -1;
+    }
+    for (uint64_t i = 7; i <= root; i++) {
+        if (!composite[i]) {
+            size_t k = base->count++;
+            base->primes[k] = (uint32_t)i;
+            for (int j = 0; j < 8; j++) {
+                base->masks[k * 8 + j] = wheelBit[(i * wheelResidues[j]) % 30];
+            }
+        }
+    }
+    base->limit = limit;
+    free(composite);
+    return 0;
+}
+
+// Position a cursor at `byte` (any segment start, need not follow the last)
+static void seekCursor(SieveCursor* cursor, uint64_t byte) {
+    const BasePrimes* base = cursor->base;
+    uint64_t low = byte * 30;
+    for (size_t i = 0; i < base->count; i++) {
+        uint64_t p = base->primes[i];
+        uint64_t m = (low + p - 1) / p;              // First multiplier reaching low
+        if (m < p) {
+            m = p;                                   // Smaller ones were crossed by smaller primes
+        }
+        uint64_t m_mod = m % 30;
+        for (int j = 0; j < 8; j++) {
+            uint64_t first = m + (wheelResidues[j] + 30 - m_mod) % 30;
+            cursor->next[i * 8 + j] = first * p / 30;
+        }
+    }
+    cursor->byte = byte;
+}
+
+static int openCursor(SieveCursor* cursor, const BasePrimes* base, uint64_t byte) {
+    cursor->base = base;
+    cursor->next = malloc((base->count + 1) * 8 * sizeof(uint64_t));
+    if (cursor->next == NULL) {
+        return -1;
+    }
+    seekCursor(cursor, byte);
+    return 0;
+}
+
+static void closeCursor(SieveCursor* cursor) {
+    free(cursor->next);
+    cursor->next = NULL;
+}
 
+// Sieve `bytes` bytes starting at cursor->byte into seg (set bit = prime,
+// except that 2, 3, 5 are not represented and 1 is cleared) and advance
+static void sieveSegment(SieveCursor* cursor, uint8_t* seg, size_t bytes) {
+    const BasePrimes* base = cursor->base;
+    uint64_t first = cursor->byte;
+    uint64_t end = first + bytes;
+    uint64_t high = end * 30;
+    memset(seg, 0xff, bytes);
+    if (first == 0) {
+        seg[0] &= (uint8_t)~0x01;                    // 1 is not prime
+    }
+    for (size_t i = 0; i < base->count; i++) {
+        uint64_t p = base->primes[i];
+        if (p * p >= high) {
+            break;
+        }
+        uint64_t* next = &cursor->next[i * 8];
+        const uint8_t* masks = &base->masks[i * 8];
+        for (int j = 0; j < 8; j++) {
+            uint64_t b = next[j];
+            uint8_t clear = (uint8_t)~masks[j];
+            for (; b < end; b += p) {
+                seg[b - first] &= clear;
+            }
+            next[j] = b;
+        }
+    }
+    cursor->byte = end;
+}
+
+// Keep only the bits of seg (covering numbers from byte * 30) that lie in [lo, hi)
+static void clipSegment(uint8_t* seg, size_t bytes, uint64_t byte, uint64_t lo, uint64_t hi) {
+    for (size_t k = 0; k < bytes && (byte + k) * 30 < lo; k++) {
+        for (int bit = 0; bit < 8; bit++) {
+            if ((byte + k) * 30 + wheelResidues[bit] < lo) {
+                seg[k] &= (uint8_t)~(1u << bit);
+            }
+        }
+    }
+    for (size_t k = bytes; k > 0 && (byte + k) * 30 > hi; k--) {
+        for (int bit = 0; bit < 8; bit++) {
+            if ((byte + k - 1) * 30 + wheelResidues[bit] >= hi) {
+                seg[k - 1] &= (uint8_t)~(1u << bit);
+            }
+        }
+    }
+}
+
+static uint64_t popcountBytes(const uint8_t* seg, size_t bytes) {
+    uint64_t total = 0;
+    size_t k = 0;
+    for (; k + 8 <= bytes; k += 8) {
+        uint64_t word;
+        memcpy(&word, seg + k, 8);
+        total += (uint64_t)__builtin_popcountll(word);
+    }
+    for (; k < bytes; k++) {
+        total += (uint64_t)__builtin_popcount(seg[k]);
+    }
+    return total;
+}
+
+// Primes among 2, 3, 5 that fall in [lo, hi)
+static uint64_t countWheelPrimes(uint64_t lo, uint64_t hi) {
+    uint64_t count = 0;
+    static const uint64_t small[3] = {2, 3, 5};
+    for (int i = 0; i < 3; i++) {
+        if (small[i] >= lo && small[i] < hi) {
+            count++;
+        }
+    }
+    return count;
+}
+
+typedef struct {
+    const BasePrimes* base;
+    uint64_t lo, hi;             // Numbers this thread owns
+    uint64_t first_byte, end_byte;
+    uint64_t count;
+    int failed;
+} CountJob;
+
+static void* countJobThread(void* arg) {
+    CountJob* job = arg;
+    SieveCursor cursor;
+    uint8_t* seg = malloc(SIEVE_SEGMENT_BYTES);
+    if (seg == NULL || openCursor(&cursor, job->base, job->first_byte) != 0) {
+        free(seg);
+        job->failed = 1;
+        return NULL;
+    }
+    for (uint64_t byte = job->first_byte; byte < job->end_byte; byte += SIEVE_SEGMENT_BYTES) {
+        size_t bytes = job->end_byte - byte < SIEVE_SEGMENT_BYTES ? (size_t)(job->end_byte - byte)
+                                                                  : SIEVE_SEGMENT_BYTES;
+        sieveSegment(&cursor, seg, bytes);
+        if (byte * 30 < job->lo || (byte + bytes) * 30 > job->hi) {
+            clipSegment(seg, bytes, byte, job->lo, job->hi);
+        }
+        job->count += popcountBytes(seg, bytes);
+    }
+    closeCursor(&cursor);
+    free(seg);
+    return NULL;
+}
+
+static int defaultThreads(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+// Number of primes in [lo, hi), or -1 on error. Each thread sieves its own
+// contiguous run of segments, so the crossing-off state carries over
+// between its segments and only one seek per thread is needed.
+long long countPrimes(uint64_t lo, uint64_t hi, int threads) {
+    if (hi > SIEVE_MAX_LIMIT) {
+        printf("Error: Sieve limit is 10^13\n");
+        return -1;
+    }
+    if (lo >= hi) {
+        return 0;
+    }
+    BasePrimes base;
+    if (initBasePrimes(&base, hi) != 0) {
+        printf("Error: Out of memory\n");
+        return -1;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > SIEVE_MAX_THREADS) {
+        threads = SIEVE_MAX_THREADS;
+    }
+
+    uint64_t first_segment = lo / SIEVE_SEGMENT_SPAN;
+    uint64_t end_segment = (hi + SIEVE_SEGMENT_SPAN - 1) / SIEVE_SEGMENT_SPAN;
+    uint64_t segments = end_segment - first_segment;
+    if ((uint64_t)threads > segments) {
+        threads = (int)segments;
+    }
+
+    CountJob jobs[SIEVE_MAX_THREADS];
+    pthread_t ids[SIEVE_MAX_THREADS];
+    int started[SIEVE_MAX_THREADS] = {0};
+    uint64_t segment = first_segment;
+    for (int t = 0; t < threads; t++) {
+        uint64_t share = segments / threads + ((uint64_t)t < segments % threads ? 1 : 0);
+        jobs[t] = (CountJob){&base, lo, hi, segment * SIEVE_SEGMENT_BYTES, 0, 0, 0};
+        segment += share;
+        jobs[t].end_byte = segment * SIEVE_SEGMENT_BYTES;
+        if ((hi + 29) / 30 < jobs[t].end_byte) {
+            jobs[t].end_byte = (hi + 29) / 30;
+        }
+    }
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&ids[t], NULL, countJobThread, &jobs[t]) == 0;
+        if (!started[t]) {
+            countJobThread(&jobs[t]);
+        }
+    }
+    countJobThread(&jobs[0]);
+    long long total = (long long)countWheelPrimes(lo, hi);
+    int failed = 0;
+    for (int t = 0; t < threads; t++) {
+        if (t > 0 && started[t]) {
+            pthread_join(ids[t], NULL);
+        }
+        failed |= jobs[t].failed;
+        total += (long long)jobs[t].count;
+    }
+    freeBasePrimes(&base);
+    if (failed) {
+        printf("Error: Out of memory\n");
+        return -1;
+    }
+    return total;
+}
+
+// Call visit(prime, context) for every prime in [lo, hi), in increasing
+// order; a non-zero return from visit stops early. Returns -1 on error.
+int forEachPrime(uint64_t lo, uint64_t hi, int (*visit)(uint64_t prime, void* context), void* context) {
+    if (hi > SIEVE_MAX_LIMIT) {
+        printf("Error: Sieve limit is 10^13\n");
+        return -1;
+    }
+    static const uint64_t small[3] = {2, 3, 5};
+    for (int i = 0; i < 3; i++) {
+        if (small[i] >= lo && small[i] < hi && visit(small[i], context) != 0) {
+            return 0;
+        }
+    }
+    if (lo >= hi) {
+        return 0;
+    }
+
+    BasePrimes base;
+    SieveCursor cursor;
+    uint8_t* seg = malloc(SIEVE_SEGMENT_BYTES);
+    if (seg == NULL || initBasePrimes(&base, hi) != 0) {
+        free(seg);
+        printf("Error: Out of memory\n");
+        return -1;
+    }
+    if (openCursor(&cursor, &base, lo / 30) != 0) {
+        free(seg);
+        freeBasePrimes(&base);
+        printf("Error: Out of memory\n");
+        return -1;
+    }
+    uint64_t end_byte = (hi + 29) / 30;
+    int stop = 0;
+    for (uint64_t byte = lo / 30; byte < end_byte && !stop; byte += SIEVE_SEGMENT_BYTES) {
+        size_t bytes = end_byte - byte < SIEVE_SEGMENT_BYTES ? (size_t)(end_byte - byte) : SIEVE_SEGMENT_BYTES;
+        sieveSegment(&cursor, seg, bytes);
+        clipSegment(seg, bytes, byte, lo, hi);
+        for (size_t k = 0; k < bytes && !stop; k++) {
+            for (unsigned bits = seg[k]; bits != 0 && !stop; bits &= bits - 1) {
+                stop = visit((byte + k) * 30 + wheelResidues[__builtin_ctz(bits)], context) != 0;
+            }
+        }
+    }
+    closeCursor(&cursor);
+    freeBasePrimes(&base);
+    free(seg);
+    return 0;
+}
+
+typedef struct {
+    const BasePrimes* base;
+    const uint64_t* values;
+    const size_t* order;         // Indices into values, sorted by value
+    size_t first, last;          // This thread's slice of order
+    unsigned char* out;
+    int failed;
+} QueryJob;
+
+static void* queryJobThread(void* arg) {
+    QueryJob* job = arg;
+    SieveCursor cursor;
+    uint8_t* seg = malloc(SIEVE_SEGMENT_BYTES);
+    if (seg == NULL || openCursor(&cursor, job->base, 0) != 0) {
+        free(seg);
+        job->failed = 1;
+        return NULL;
+    }
+    uint64_t loaded = UINT64_MAX;                    // Segment held in seg
+    for (size_t q = job->first; q < job->last; q++) {
+        size_t index = job->order[q];
+        uint64_t n = job->values[index];
+        uint8_t bit = wheelBit[n % 30];
+        if (n < 7 || bit == 0) {
+            job->out[index] = n == 2 || n == 3 || n == 5;
+            continue;
+        }
+        uint64_t segment = n / SIEVE_SEGMENT_SPAN;
+        if (segment != loaded) {
+            // Consecutive segments continue the crossing-off state; a gap
+            // needs a seek
+            if (segment * SIEVE_SEGMENT_BYTES != cursor.byte) {
+                seekCursor(&cursor, segment * SIEVE_SEGMENT_BYTES);
+            }
+            sieveSegment(&cursor, seg, SIEVE_SEGMENT_BYTES);
+            loaded = segment;
+        }
+        job->out[index] = (seg[n / 30 - segment * SIEVE_SEGMENT_BYTES] & bit) != 0;
+    }
+    closeCursor(&cursor);
+    free(seg);
+    return NULL;
+}
+
+// A query's value sorted together with its position, so the comparison
+// needs no pointer back to the values (and primeQueryBatch stays reentrant)
+typedef struct {
+    uint64_t value;
+    size_t index;
+} QueryKey;
+
+static int compareQueryKeys(const void* a, const void* b) {
+    uint64_t x = ((const QueryKey*)a)->value;
+    uint64_t y = ((const QueryKey*)b)->value;
+    return (x > y) - (x < y);
+}
+
+// out[i] = 1 if values[i] is prime. The queries are grouped by segment so
+// each sieve segment is built once however many queries fall into it, and
+// only segments that hold a query are sieved. Returns -1 on error.
+int primeQueryBatch(const uint64_t* values, size_t count, unsigned char* out, int threads) {
+    uint64_t max = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (values[i] > max) {
+            max = values[i];
+        }
+    }
+    if (max >= SIEVE_MAX_LIMIT) {
+        printf("Error: Sieve limit is 10^13\n");
+        return -1;
+    }
+    size_t* order = malloc((count + 1) * sizeof(size_t));
+    BasePrimes base;
+    if (order == NULL || initBasePrimes(&base, max + 1) != 0) {
+        free(order);
+        printf("Error: Out of memory\n");
+        return -1;
+    }
+    // Group the queries by segment: a counting sort when there are not many
+    // more segments than queries, a comparison sort otherwise
+    uint64_t segments = max / SIEVE_SEGMENT_SPAN + 1;
+    size_t* start = segments <= 4 * (uint64_t)count + 1024 ? calloc(segments + 1, sizeof(size_t)) : NULL;
+    if (start != NULL) {
+        for (size_t i = 0; i < count; i++) {
+            start[values[i] / SIEVE_SEGMENT_SPAN + 1]++;
+        }
+        for (uint64_t g = 0; g < segments; g++) {
+            start[g + 1] += start[g];
+        }
+        for (size_t i = 0; i < count; i++) {
+            order[start[values[i] / SIEVE_SEGMENT_SPAN]++] = i;
+        }
+        free(start);
+    } else {
+        QueryKey* keys = malloc((count + 1) * sizeof(QueryKey));
+        if (keys == NULL) {
+            freeBasePrimes(&base);
+            free(order);
+            printf("Error: Out of memory\n");
+            return -1;
+        }
+        for (size_t i = 0; i < count; i++) {
+            keys[i] = (QueryKey){values[i], i};
+        }
+        qsort(keys, count, sizeof(QueryKey), compareQueryKeys);
+        for (size_t i = 0; i < count; i++) {
+            order[i] = keys[i].index;
+        }
+        free(keys);
+    }
+
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > SIEVE_MAX_THREADS) {
+        threads = SIEVE_MAX_THREADS;
+    }
+    // Slice boundaries are moved forward to segment changes so that no
+    // segment is sieved by two threads
+    QueryJob jobs[SIEVE_MAX_THREADS];
+    pthread_t ids[SIEVE_MAX_THREADS];
+    int started[SIEVE_MAX_THREADS] = {0};
+    size_t first = 0;
+    for (int t = 0; t < threads; t++) {
+        size_t last = t == threads - 1 ? count : count / threads * (size_t)(t + 1);
+        if (last < first) {
+            last = first;
+        }
+        while (last > first && last < count &&
+               values[order[last]] / SIEVE_SEGMENT_SPAN == values[order[last - 1]] / SIEVE_SEGMENT_SPAN) {
+            last++;
+        }
+        jobs[t] = (QueryJob){&base, values, order, first, last, out, 0};
+        first = last;
+    }
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&ids[t], NULL, queryJobThread, &jobs[t]) == 0;
+        if (!started[t]) {
+            queryJobThread(&jobs[t]);
+        }
+    }
+    queryJobThread(&jobs[0]);
+    int failed = 0;
+    for (int t = 0; t < threads; t++) {
+        if (t > 0 && started[t]) {
+            pthread_join(ids[t], NULL);
+        }
+        failed |= jobs[t].failed;
+    }
+    freeBasePrimes(&base);
+    free(order);
+    if (failed) {
+        printf("Error: Out of memory\n");
+        return -1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Deterministic 64-bit Miller-Rabin
+// ---------------------------------------------------------------------------
+
+// Odd primes used by the trial-division prefilter. p divides n exactly when
+// n * p^-1 (mod 2^64) <= (2^64 - 1) / p, which needs no division.
+#define PREFILTER_PRIMES 24
+#define PREFILTER_LIMIT 101             // Every n < 101^2 that survives is prime
+
+typedef struct {
+    uint64_t inverse;                    // p^-1 mod 2^64
+    uint64_t limit;                      // (2^64 - 1) / p
+} DivisibilityTest;
+
+static const uint32_t prefilterPrimes[PREFILTER_PRIMES] = {
+    3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67, 71, 73, 79, 83, 89, 97,
+};
+
+static DivisibilityTest prefilterTests[PREFILTER_PRIMES];
+
+// n^-1 mod 2^64 for odd n (the positive inverse, n * x = 1 mod 2^64), by
+// Newton's iteration: each step doubles the number of correct low bits,
+// starting from 3 bits for x = n. montgomeryMul() subtracts k * n, and the
+// prefilter multiplies by it, so both rely on it being +n^-1, not -n^-1.
+static uint64_t inverse64(uint64_t n) {
+    uint64_t x = n;
+    for (int i = 0; i < 5; i++) {
+        x *= 2 - n * x;
+    }
+    return x;
+}
+
+static void initPrefilter(void) {
+    if (prefilterTests[0].inverse != 0) {
+        return;
+    }
+    for (int i = 0; i < PREFILTER_PRIMES; i++) {
+        prefilterTests[i].inverse = inverse64(prefilterPrimes[i]);
+        prefilterTests[i].limit = UINT64_MAX / prefilterPrimes[i];
+    }
+}
+
+// 0 = composite, 1 = prime, 2 = needs Miller-Rabin
+static int prefilter(uint64_t n) {
     if (n < 2) {
-        printf("%d is not a prime number.\n", n);
         return 0;
     }
+    if ((n & 1) == 0) {
+        return n == 2;
+    }
+    for (int i = 0; i < PREFILTER_PRIMES; i++) {
+        if (n * prefilterTests[i].inverse <= prefilterTests[i].limit) {
+            return n == prefilterPrimes[i];
+        }
+    }
+    return n < (uint64_t)PREFILTER_LIMIT * PREFILTER_LIMIT ? 1 : 2;
+}
+
+// Arithmetic mod an odd n on Montgomery representatives x * 2^64 mod n
+typedef struct {
+    uint64_t n;
+    uint64_t inverse;                    // n^-1 mod 2^64
+    uint64_t one;                        // 2^64 mod n
+    uint64_t r2;                         // 2^128 mod n
+} Montgomery;
+
+static void montgomeryInit(Montgomery* m, uint64_t n) {
+    m->n = n;
+    m->inverse = inverse64(n);
+    m->one = (0 - n) % n;
+    m->r2 = (uint64_t)((unsigned __int128)m->one * m->one % n);
+}
+
+// a * b / 2^64 mod n
+static inline uint64_t montgomeryMul(const Montgomery* m, uint64_t a, uint64_t b) {
+    unsigned __int128 t = (unsigned __int128)a * b;
+    uint64_t k = (uint64_t)t * m->inverse;
+    uint64_t high = (uint64_t)(t >> 64);
+    uint64_t correction = (uint64_t)(((unsigned __int128)k * m->n) >> 64);
+    return high >= correction ? high - correction : high - correction + m->n;
+}
+
+static inline uint64_t montgomeryFrom(const Montgomery* m, uint64_t x) {
+    return montgomeryMul(m, x % m->n, m->r2);
+}
+
+// Is n a strong probable prime to base a? (n odd, n - 1 = d * 2^s)
+static int strongProbablePrime(const Montgomery* m, uint64_t a, uint64_t d, int s) {
+    uint64_t base = montgomeryFrom(m, a);
+    if (base == 0) {
+        return 1;                        // a = 0 mod n tells us nothing
+    }
+    uint64_t minus_one = m->n - m->one;
+    uint64_t x = m->one;
+    for (int bit = 63 - __builtin_clzll(d); bit >= 0; bit--) {
+        x = montgomeryMul(m, x, x);
+        if ((d >> bit) & 1) {
+            x = montgomeryMul(m, x, base);
+        }
+    }
+    if (x == m->one || x == minus_one) {
+        return 1;
+    }
+    for (int i = 1; i < s; i++) {
+        x = montgomeryMul(m, x, x);
+        if (x == minus_one) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Bases that make Miller-Rabin exact below 2^32 and below 2^64
+static const uint64_t basesBelow2to32[] = {2, 7, 61};
+static const uint64_t basesBelow2to64[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+
+static int millerRabin(uint64_t n, int skip_base2) {
+    Montgomery m;
+    montgomeryInit(&m, n);
+    uint64_t d = n - 1;
+    int s = __builtin_ctzll(d);
+    d >>= s;
+    const uint64_t* bases = n < (1ULL << 32) ? basesBelow2to32 : basesBelow2to64;
+    int count = n < (1ULL << 32) ? 3 : 7;
+    for (int i = skip_base2 ? 1 : 0; i < count; i++) {
+        if (!strongProbablePrime(&m, bases[i], d, s)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Exact primality for any 64-bit n
+int isPrime64(uint64_t n) {
+    initPrefilter();
+    int verdict = prefilter(n);
+    return verdict == 2 ? millerRabin(n, 0) : verdict;
+}
+
+#define BATCH_LANES 4
+#define BATCH_GROUP 1024
+
+// Strong probable prime test of n[l] to base a[l] for BATCH_LANES numbers
+// at once. The Montgomery products of one number depend on each other, so
+// interleaving independent numbers keeps the multiplier busy instead of
+// waiting on each product.
+static void strongProbablePrimeLanes(const uint64_t* n, const uint64_t* a, unsigned char* pass) {
+    Montgomery m[BATCH_LANES];
+    uint64_t d[BATCH_LANES], x[BATCH_LANES], base[BATCH_LANES];
+    int s[BATCH_LANES], top = 0;
+    for (int l = 0; l < BATCH_LANES; l++) {
+        montgomeryInit(&m[l], n[l]);
+        s[l] = __builtin_ctzll(n[l] - 1);
+        d[l] = (n[l] - 1) >> s[l];
+        base[l] = montgomeryFrom(&m[l], a[l]);
+        x[l] = m[l].one;
+        int bits = 64 - __builtin_clzll(d[l]);
+        top = bits > top ? bits : top;
+    }
+    // Leading zero bits square one into one, so all lanes can run `top` steps
+    for (int bit = top - 1; bit >= 0; bit--) {
+        for (int l = 0; l < BATCH_LANES; l++) {
+            x[l] = montgomeryMul(&m[l], x[l], x[l]);
+            uint64_t product = montgomeryMul(&m[l], x[l], base[l]);
+            x[l] = (d[l] >> bit) & 1 ? product : x[l];
+        }
+    }
+    for (int l = 0; l < BATCH_LANES; l++) {
+        uint64_t minus_one = m[l].n - m[l].one;
+        pass[l] = base[l] == 0 || x[l] == m[l].one || x[l] == minus_one;
+        for (int i = 1; i < s[l] && !pass[l]; i++) {
+            x[l] = montgomeryMul(&m[l], x[l], x[l]);
+            pass[l] = x[l] == minus_one;
+        }
+    }
+}
+
+// out[i] = isPrime64(values[i]). Works through the input BATCH_GROUP values
+// at a time: the prefilter settles most of them, then each Miller-Rabin
+// round runs BATCH_LANES survivors side by side and drops the composites.
+void isPrime64Batch(const uint64_t* values, size_t count, unsigned char* out) {
+    size_t survivors[BATCH_GROUP];
+    initPrefilter();
+    for (size_t group = 0; group < count; group += BATCH_GROUP) {
+        size_t end = count - group < BATCH_GROUP ? count : group + BATCH_GROUP;
+        size_t alive = 0;
+        for (size_t i = group; i < end; i++) {
+            int verdict = prefilter(values[i]);
+            out[i] = (unsigned char)(verdict != 0);
+            if (verdict == 2) {
+                survivors[alive++] = i;
+            }
+        }
+        for (int round = 0; round < 7 && alive > 0; round++) {
+            size_t kept = 0;
+            for (size_t first = 0; first < alive; first += BATCH_LANES) {
+                uint64_t n[BATCH_LANES], a[BATCH_LANES];
+                unsigned char pass[BATCH_LANES];
+                int lanes = alive - first < BATCH_LANES ? (int)(alive - first) : BATCH_LANES;
+                for (int l = 0; l < BATCH_LANES; l++) {
+                    n[l] = values[survivors[first + (l < lanes ? l : 0)]];
+                    a[l] = n[l] < (1ULL << 32) ? basesBelow2to32[round < 3 ? round : 0] : basesBelow2to64[round];
+                }
+                strongProbablePrimeLanes(n, a, pass);
+                for (int l = 0; l < lanes; l++) {
+                    size_t index = survivors[first + l];
+                    if (!pass[l]) {
+                        out[index] = 0;
+                    } else if (round < 2 || values[index] >= (1ULL << 32)) {
+                        survivors[kept++] = index;       // More bases to go
+                    }
+                }
+            }
+            alive = kept;
+        }
+    }
+}
 
-    for (i = 2; i * i <= n; ++i) {
+// ---------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------
+
+// The original per-number check, for comparison
+static int isPrimeTrial(uint64_t n) {
+    if (n < 2) {
+        return 0;
+    }
+    for (uint64_t i = 2; i * i <= n; ++i) {
         if (n % i == 0) {
-            isPrime = 0;
-            break;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int printPrime(uint64_t prime, void* context) {
+    (void)context;
+    printf("%llu\n", (unsigned long long)prime);
+    return 0;
+}
+
+static void benchmarkSieve(uint64_t limit, int threads) {
+    printf("Counting primes below %llu\n", (unsigned long long)limit);
+    printf("%-8s %14s %10s %16s\n", "threads", "primes", "seconds", "numbers/s");
+    for (int t = 1; t <= threads; t *= 2) {
+        double start = nowSeconds();
+        long long count = countPrimes(0, limit, t);
+        double seconds = nowSeconds() - start;
+        if (count < 0) {
+            return;
+        }
+        printf("%-8d %14lld %10.3f %16.3e\n", t, count, seconds, limit / seconds);
+        if (t < threads && t * 2 > threads) {
+            t = threads / 2;                         // Always finish with `threads`
+        }
+    }
+
+    // Bulk membership against trial division on the same random numbers
+    size_t queries = 10000000;
+    uint64_t* values = malloc(queries * sizeof(uint64_t));
+    unsigned char* out = malloc(queries);
+    if (values == NULL || out == NULL) {
+        free(values);
+        free(out);
+        printf("Error: Out of memory\n");
+        return;
+    }
+    uint64_t state = 88172645463325252ULL;
+    for (size_t i = 0; i < queries; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        values[i] = state % limit;
+    }
+    double start = nowSeconds();
+    if (primeQueryBatch(values, queries, out, threads) != 0) {
+        free(values);
+        free(out);
+        return;
+    }
+    double batch_seconds = nowSeconds() - start;
+
+    size_t checked = 20000;                          // Trial division is slow
+    int mismatches = 0;
+    start = nowSeconds();
+    for (size_t i = 0; i < checked; i++) {
+        if (isPrimeTrial(values[i]) != out[i]) {
+            mismatches++;
+        }
+    }
+    double trial_seconds = nowSeconds() - start;
+    printf("Bulk queries:     %.3e numbers/s (%zu random values < limit)\n", queries / batch_seconds, queries);
+    printf("Trial division:   %.3e numbers/s (%zu values, %d disagreements)\n", checked / trial_seconds,
+           checked, mismatches);
+    free(values);
+    free(out);
+}
+
+// Compare isPrime64() and isPrime64Batch() with the sieve for every n < limit
+static void validateMillerRabin(uint64_t limit) {
+    BasePrimes base;
+    SieveCursor cursor;
+    uint8_t* seg = malloc(SIEVE_SEGMENT_BYTES);
+    uint64_t* values = malloc(SIEVE_SEGMENT_SPAN * sizeof(uint64_t));
+    unsigned char* out = malloc(SIEVE_SEGMENT_SPAN);
+    if (seg == NULL || values == NULL || out == NULL || limit > SIEVE_MAX_LIMIT ||
+        initBasePrimes(&base, limit) != 0) {
+        printf("Error: Cannot set up validation below %llu\n", (unsigned long long)limit);
+        free(seg);
+        free(values);
+        free(out);
+        return;
+    }
+    if (openCursor(&cursor, &base, 0) != 0) {
+        printf("Error: Out of memory\n");
+        freeBasePrimes(&base);
+        free(seg);
+        free(values);
+        free(out);
+        return;
+    }
+
+    uint64_t mismatches = 0, primes = 0;
+    double batch_seconds = 0.0, scalar_seconds = 0.0;
+    for (uint64_t low = 0; low < limit; low += SIEVE_SEGMENT_SPAN) {
+        sieveSegment(&cursor, seg, SIEVE_SEGMENT_BYTES);
+        size_t count = limit - low < SIEVE_SEGMENT_SPAN ? (size_t)(limit - low) : (size_t)SIEVE_SEGMENT_SPAN;
+        for (size_t i = 0; i < count; i++) {
+            values[i] = low + i;
+        }
+        double start = nowSeconds();
+        isPrime64Batch(values, count, out);
+        batch_seconds += nowSeconds() - start;
+
+        start = nowSeconds();
+        for (size_t i = 0; i < count; i++) {
+            uint64_t n = values[i];
+            uint8_t bit = wheelBit[n % 30];
+            int expected = bit ? (seg[i / 30] & bit) != 0 : (n == 2 || n == 3 || n == 5);
+            int scalar = isPrime64(n);
+            primes += (uint64_t)expected;
+            if (scalar != expected || out[i] != expected) {
+                if (mismatches++ < 10) {
+                    printf("Mismatch at %llu: sieve %d, isPrime64 %d, batch %d\n", (unsigned long long)n,
+                           expected, scalar, out[i]);
+                }
+            }
+        }
+        scalar_seconds += nowSeconds() - start;
+    }
+    printf("Checked every n < %llu: %llu primes, %llu mismatches\n", (unsigned long long)limit,
+           (unsigned long long)primes, (unsigned long long)mismatches);
+    printf("isPrime64Batch: %.3e numbers/s; isPrime64 (with the comparison loop): %.3e numbers/s\n",
+           limit / batch_seconds, limit / scalar_seconds);
+    closeCursor(&cursor);
+    freeBasePrimes(&base);
+    free(seg);
+    free(values);
+    free(out);
+}
+
+// Random 64-bit inputs, where trial division and sieving are out of reach
+static void benchmarkMillerRabin(size_t count) {
+    uint64_t* values = malloc(count * sizeof(uint64_t));
+    unsigned char* out = malloc(count);
+    if (values == NULL || out == NULL) {
+        printf("Error: Out of memory\n");
+        free(values);
+        free(out);
+        return;
+    }
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < count; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        values[i] = state | 1;
+    }
+    printf("%-28s %16s %10s\n", "input", "numbers/s", "primes");
+    for (int kind = 0; kind < 2; kind++) {
+        if (kind == 1) {
+            // Keep only the primes: the worst case, every base runs
+            size_t kept = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (out[i]) {
+                    values[kept++] = values[i];
+                }
+            }
+            count = kept;
+        }
+        double start = nowSeconds();
+        size_t found = 0;
+        for (size_t i = 0; i < count; i++) {
+            found += (size_t)isPrime64(values[i]);
         }
+        double scalar = nowSeconds() - start;
+        start = nowSeconds();
+        isPrime64Batch(values, count, out);
+        double batch = nowSeconds() - start;
+        const char* name = kind == 0 ? "random odd 64-bit" : "64-bit primes";
+        printf("%-28s %16.3e %10zu  isPrime64\n", name, count / scalar, found);
+        printf("%-28s %16.3e %10s  isPrime64Batch\n", "", count / batch, "");
+    }
+    free(values);
+    free(out);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 4 && strcmp(argv[1], "--count") == 0) {
+        long long count = countPrimes(strtoull(argv[2], NULL, 10), strtoull(argv[3], NULL, 10),
+                                      argc >= 5 ? atoi(argv[4]) : defaultThreads());
+        if (count < 0) {
+            return 1;
+        }
+        printf("%lld\n", count);
+        return 0;
+    }
+    if (argc >= 4 && strcmp(argv[1], "--list") == 0) {
+        return forEachPrime(strtoull(argv[2], NULL, 10), strtoull(argv[3], NULL, 10), printPrime, NULL) == 0
+                   ? 0
+                   : 1;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--validate") == 0) {
+        validateMillerRabin(argc >= 3 ? strtoull(argv[2], NULL, 10) : 1000000000ULL);
+        return 0;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench-mr") == 0) {
+        benchmarkMillerRabin(argc >= 3 ? (size_t)strtoull(argv[2], NULL, 10) : 2000000);
+        return 0;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        benchmarkSieve(argc >= 3 ? strtoull(argv[2], NULL, 10) : 1000000000ULL,
+                       argc >= 4 ? atoi(argv[3]) : defaultThreads());
+        return 0;
+    }
+
+    char line[64];
+    char* end;
+
+    printf("Enter a positive integer: ");
+    if (fgets(line, sizeof(line), stdin) == NULL) {
+        printf("Error: No input\n");
+        return 1;
+    }
+    line[strcspn(line, "\n")] = 0;
+    errno = 0;
+    unsigned long long n = strtoull(line, &end, 10);
+    if (end == line || *end != '\0' || errno == ERANGE) {
+        printf("Error: Please enter an integer below 2^64\n");
+        return 1;
+    }
+    if (strchr(line, '-') != NULL) {
+        printf("%s is not a prime number.\n", line);   // Negative numbers
+        return 0;
     }
 
-    if (isPrime)
-        printf("%d is a prime number.\n", n);
+    if (isPrime64(n))
+        printf("%llu is a prime number.\n", n);
     else
-        printf("%d is not a prime number.\n", n);
+        printf("%llu is not a prime number.\n", n);
 
     return 0;
 
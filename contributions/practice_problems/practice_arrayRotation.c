@@ -24,17 +24,55 @@
  * 2. Reverse the first k elements
  * 3. Reverse the remaining elements
  * 
+ * Reversal reads and writes every element twice. For large arrays
+ * rotateArray() picks one of three cheaper methods instead:
+ * - Buffer: when the shorter side fits ROTATE_BUFFER_BYTES, copy it aside,
+ *   memmove the longer side into place and copy it back (~1 pass).
+ * - Juggling: follow the gcd(n, k) cycles, moving each element once. The
+ *   jumps are k apart, so it is only chosen while the array fits in cache.
+ * - Block swap (Gries-Mills): swap the shorter side with the matching end
+ *   of the longer one until the remainder fits the buffer. Every swap is a
+ *   sequential run, so it streams well out of cache.
+ * 
+ * All of these work on elements of any size (rotateElements(), and
+ * reverseElements() underneath the reversal method). Reversal of 1/2/4/8/16
+ * byte elements swaps 32 bytes from each end per step, reordered with AVX2
+ * shuffles/permutes; reverseParallel() gives each thread a contiguous run of
+ * the n/2 independent swaps. rotateFile()/reverseFile() do the same on a
+ * memory-mapped file, so arrays larger than RAM are paged through.
+ * 
  * Time Complexity: O(n) where n is the length of the array
- * Space Complexity: O(1) - using constant extra space
+ * Space Complexity: O(1) - using constant extra space (a fixed 64 KB buffer)
  * 
  * Test Cases:
  * - [1,2,3,4,5,6,7], k=3 -> [5,6,7,1,2,3,4]
  * - [-1,-100,3,99], k=2 -> [3,99,-1,-100]
  * - [1,2], k=1 -> [2,1]
  * - [1], k=1 -> [1]
+ * - [1,2,3,4,5], k=-1 -> [2,3,4,5,1] (negative k rotates left)
+ * - ./arrayRotation --bench [MILLIONS] checks every method against the
+ *   expected result and times them for several k on a large array
+ * - ./arrayRotation --bench-reverse [MB] [THREADS] checks and times scalar,
+ *   SIMD and threaded reversal for element sizes 1, 2, 4, 8, 16 and 12
+ * - ./arrayRotation --rotate-file FILE ELEM_SIZE K and
+ *   --reverse-file FILE ELEM_SIZE [THREADS] work in place (build with -pthread)
+ * - Interactive input is sized by n (no fixed 100-element array)
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 // Function to reverse array elements from start to end
 void reverse(int arr[], int start, int end) {
@@ -47,8 +85,8 @@ void reverse(int arr[], int start, int end) {
     }
 }
 
-// Function to rotate array to the right by k steps
-void rotateArray(int arr[], int n, int k) {
+// Function to rotate array to the right by k steps (three reversals)
+void rotateReversal(int arr[], int n, int k) {
     // Handle case where k is greater than array length
     k = k % n;
     
@@ -67,6 +105,441 @@ void rotateArray(int arr[], int n, int k) {
     reverse(arr, k, n - 1);
 }
 
+#define ROTATE_BUFFER_BYTES (64 * 1024)
+#define ROTATE_CACHE_BYTES (256 * 1024)     // Roughly one core's L2
+#define ROTATE_MAX_JUGGLE_SIZE 64           // Largest element juggled via a temp
+#define REVERSE_PARALLEL_MIN_BYTES (8u << 20)
+
+static size_t gcd(size_t a, size_t b) {
+    while (b != 0) {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// ---------------------------------------------------------------------------
+// Reversal of arbitrary-size elements
+// ---------------------------------------------------------------------------
+
+// Swap element i after `front` with element i before `back_end`, for
+// i < pairs. Reversing n elements is reversePairs(base, base + n * size, n / 2).
+#define REVERSE_PAIRS_TYPED(type)                                  \
+    for (size_t i = 0; i < pairs; i++) {                           \
+        type x, y;                                                 \
+        memcpy(&x, front + i * sizeof(type), sizeof(type));        \
+        memcpy(&y, back_end - (i + 1) * sizeof(type), sizeof(type)); \
+        memcpy(front + i * sizeof(type), &y, sizeof(type));        \
+        memcpy(back_end - (i + 1) * sizeof(type), &x, sizeof(type)); \
+    }
+
+static void reversePairsScalar(char* front, char* back_end, size_t pairs, size_t size) {
+    switch (size) {
+        case 1:
+            REVERSE_PAIRS_TYPED(uint8_t)
+            break;
+        case 2:
+            REVERSE_PAIRS_TYPED(uint16_t)
+            break;
+        case 4:
+            REVERSE_PAIRS_TYPED(uint32_t)
+            break;
+        case 8:
+            REVERSE_PAIRS_TYPED(uint64_t)
+            break;
+        default:
+            for (size_t i = 0; i < pairs; i++) {
+                char* a = front + i * size;
+                char* b = back_end - (i + 1) * size;
+                for (size_t byte = 0; byte < size; byte++) {
+                    char temp = a[byte];
+                    a[byte] = b[byte];
+                    b[byte] = temp;
+                }
+            }
+            break;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Reverse the order of 1/2/4/8/16-byte elements inside a 32-byte vector
+__attribute__((target("avx2")))
+static inline __m256i reverseVector(__m256i v, size_t size) {
+    switch (size) {
+        case 1:
+            v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                                        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+            return _mm256_permute2x128_si256(v, v, 1);
+        case 2:
+            v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1,
+                                                        14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1));
+            return _mm256_permute2x128_si256(v, v, 1);
+        case 4:
+            return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+        case 8:
+            return _mm256_permute4x64_epi64(v, 0x1b);
+        default:
+            return _mm256_permute2x128_si256(v, v, 1);
+    }
+}
+
+#define REVERSE_AVX2_LOOP(size)                                                         \
+    for (; pairs - done >= 32 / (size); done += 32 / (size)) {                           \
+        char* a = front + done * (size);                                                \
+        char* b = back_end - done * (size) - 32;                                        \
+        __m256i x = _mm256_loadu_si256((const __m256i*)a);                              \
+        __m256i y = _mm256_loadu_si256((const __m256i*)b);                              \
+        _mm256_storeu_si256((__m256i*)a, reverseVector(y, size));                        \
+        _mm256_storeu_si256((__m256i*)b, reverseVector(x, size));                        \
+    }
+
+// 32 bytes from each end per step; returns how many pairs it swapped
+__attribute__((target("avx2")))
+static size_t reversePairsAvx2(char* front, char* back_end, size_t pairs, size_t size) {
+    size_t done = 0;
+    switch (size) {
+        case 1:
+            REVERSE_AVX2_LOOP(1)
+            break;
+        case 2:
+            REVERSE_AVX2_LOOP(2)
+            break;
+        case 4:
+            REVERSE_AVX2_LOOP(4)
+            break;
+        case 8:
+            REVERSE_AVX2_LOOP(8)
+            break;
+        case 16:
+            REVERSE_AVX2_LOOP(16)
+            break;
+    }
+    return done;
+}
+#endif
+
+static void reversePairs(char* front, char* back_end, size_t pairs, size_t size) {
+    size_t done = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    static int simd = -1;
+    if (simd < 0) {
+        simd = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    if (simd && size <= 16 && (size & (size - 1)) == 0) {
+        done = reversePairsAvx2(front, back_end, pairs, size);
+    }
+#endif
+    reversePairsScalar(front + done * size, back_end - done * size, pairs - done, size);
+}
+
+// Reverse n elements of `size` bytes each
+void reverseElements(void* base, size_t n, size_t size) {
+    reversePairs(base, (char*)base + n * size, n / 2, size);
+}
+
+typedef struct {
+    char* front;
+    char* back_end;
+    size_t pairs;
+    size_t size;
+} ReverseJob;
+
+static void* reverseJobThread(void* arg) {
+    ReverseJob* job = arg;
+    reversePairs(job->front, job->back_end, job->pairs, job->size);
+    return NULL;
+}
+
+// Reverse with several threads: the n / 2 swaps are independent, so each
+// thread takes a contiguous run of them (one stretch at each end)
+void reverseParallel(void* base, size_t n, size_t size, int threads) {
+    size_t pairs = n / 2;
+    if (threads > 64) {
+        threads = 64;
+    }
+    if (threads <= 1 || pairs * size < REVERSE_PARALLEL_MIN_BYTES) {
+        reverseElements(base, n, size);
+        return;
+    }
+    ReverseJob jobs[64];
+    pthread_t ids[64];
+    int started[64];
+    size_t first = 0;
+    for (int t = 0; t < threads; t++) {
+        size_t count = pairs / threads + ((size_t)t < pairs % threads ? 1 : 0);
+        jobs[t].front = (char*)base + first * size;
+        jobs[t].back_end = (char*)base + (n - first) * size;
+        jobs[t].pairs = count;
+        jobs[t].size = size;
+        first += count;
+    }
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&ids[t], NULL, reverseJobThread, &jobs[t]) == 0;
+        if (!started[t]) {
+            reverseJobThread(&jobs[t]);
+        }
+    }
+    reverseJobThread(&jobs[0]);
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) {
+            pthread_join(ids[t], NULL);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Rotation of arbitrary-size elements (all rotate left by d internally)
+// ---------------------------------------------------------------------------
+
+// Copy the shorter side aside, memmove the longer one, copy it back
+// (min(d, n - d) * size must be <= ROTATE_BUFFER_BYTES)
+static void rotateBuffer(char* base, size_t n, size_t size, size_t d) {
+    char buffer[ROTATE_BUFFER_BYTES];
+    size_t left = d * size, right = (n - d) * size;
+    if (left <= right) {
+        memcpy(buffer, base, left);
+        memmove(base, base + left, right);
+        memcpy(base + right, buffer, left);
+    } else {
+        memcpy(buffer, base + left, right);
+        memmove(base + right, base, left);
+        memcpy(base, buffer, right);
+    }
+}
+
+// Move each element once along the gcd(n, d) cycles
+// (size must be <= ROTATE_MAX_JUGGLE_SIZE)
+static void rotateJuggling(char* base, size_t n, size_t size, size_t d) {
+    char temp[ROTATE_MAX_JUGGLE_SIZE];
+    size_t cycles = gcd(n, d);
+    for (size_t start = 0; start < cycles; start++) {
+        memcpy(temp, base + start * size, size);
+        size_t j = start;
+        for (;;) {
+            size_t next = j + d;
+            if (next >= n) {
+                next -= n;
+            }
+            if (next == start) {
+                break;
+            }
+            memcpy(base + j * size, base + next * size, size);
+            j = next;
+        }
+        memcpy(base + j * size, temp, size);
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Exchange 64 bytes per step straight from registers; returns bytes done
+__attribute__((target("avx2")))
+static size_t swapBlocksAvx2(char* a, char* b, size_t bytes) {
+    size_t done = 0;
+    for (; bytes - done >= 64; done += 64) {
+        __m256i x0 = _mm256_loadu_si256((const __m256i*)(a + done));
+        __m256i x1 = _mm256_loadu_si256((const __m256i*)(a + done + 32));
+        __m256i y0 = _mm256_loadu_si256((const __m256i*)(b + done));
+        __m256i y1 = _mm256_loadu_si256((const __m256i*)(b + done + 32));
+        _mm256_storeu_si256((__m256i*)(a + done), y0);
+        _mm256_storeu_si256((__m256i*)(a + done + 32), y1);
+        _mm256_storeu_si256((__m256i*)(b + done), x0);
+        _mm256_storeu_si256((__m256i*)(b + done + 32), x1);
+    }
+    return done;
+}
+#endif
+
+// Exchange two non-overlapping byte ranges (the tail through a bounce buffer)
+static void swapBlocks(char* a, char* b, size_t bytes) {
+    char temp[256];
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) {
+        size_t done = swapBlocksAvx2(a, b, bytes);
+        a += done;
+        b += done;
+        bytes -= done;
+    }
+#endif
+    while (bytes > 0) {
+        size_t chunk = bytes < sizeof(temp) ? bytes : sizeof(temp);
+        memcpy(temp, a, chunk);
+        memcpy(a, b, chunk);
+        memcpy(b, temp, chunk);
+        a += chunk;
+        b += chunk;
+        bytes -= chunk;
+    }
+}
+
+// Gries-Mills block swaps. base[lo, lo + left) and base[lo + left,
+// lo + left + right) (in elements) are the two sides still to exchange.
+static void rotateBlockSwap(char* base, size_t n, size_t size, size_t d) {
+    size_t lo = 0, left = d, right = n - d;
+    while (left != right) {
+        size_t smaller = left < right ? left : right;
+        if (smaller * size <= ROTATE_BUFFER_BYTES) {
+            rotateBuffer(base + lo * size, left + right, size, left);
+            return;
+        }
+        if (left < right) {
+            // A B1 B2 with |B2| = |A|: swap A and B2, then rotate A B1 at lo
+            swapBlocks(base + lo * size, base + (lo + right) * size, left * size);
+            right -= left;
+        } else {
+            // A1 A2 B with |A1| = |B|: swap A1 and B, then rotate A2 A1 after B
+            swapBlocks(base + lo * size, base + (lo + left) * size, right * size);
+            lo += right;
+            left -= right;
+        }
+    }
+    swapBlocks(base + lo * size, base + (lo + left) * size, left * size);
+}
+
+// Three reversals, with the vectorized reverse
+static void rotateByReversal(char* base, size_t n, size_t size, size_t d) {
+    reverseElements(base, d, size);
+    reverseElements(base + d * size, n - d, size);
+    reverseElements(base, n, size);
+}
+
+typedef enum {
+    ROTATE_REVERSAL,
+    ROTATE_BUFFER,
+    ROTATE_JUGGLING,
+    ROTATE_BLOCK_SWAP
+} RotateMethod;
+
+static const char* rotateMethodNames[] = {"reversal", "buffer", "juggling", "block swap"};
+
+// Pick the method with the least memory traffic for this shape
+static RotateMethod chooseRotateMethod(size_t n, size_t d, size_t size) {
+    size_t smaller = d < n - d ? d : n - d;
+    if (smaller * size <= ROTATE_BUFFER_BYTES) {
+        return ROTATE_BUFFER;
+    }
+    if (n * size <= ROTATE_CACHE_BYTES && size <= ROTATE_MAX_JUGGLE_SIZE) {
+        return ROTATE_JUGGLING;
+    }
+    return ROTATE_BLOCK_SWAP;
+}
+
+// Rotate right by k with the given method
+static void rotateWith(RotateMethod method, void* base, size_t n, size_t size, size_t k) {
+    if (n == 0 || k % n == 0) {
+        return;
+    }
+    size_t d = n - k % n;            // Right by k == left by n - k
+    switch (method) {
+        case ROTATE_REVERSAL:
+            rotateByReversal(base, n, size, d);
+            break;
+        case ROTATE_BUFFER:
+            rotateBuffer(base, n, size, d);
+            break;
+        case ROTATE_JUGGLING:
+            rotateJuggling(base, n, size, d);
+            break;
+        case ROTATE_BLOCK_SWAP:
+            rotateBlockSwap(base, n, size, d);
+            break;
+    }
+}
+
+// Rotate n elements of `size` bytes each to the right by k steps
+void rotateElements(void* base, size_t n, size_t size, size_t k) {
+    if (n == 0 || k % n == 0) {
+        return;
+    }
+    rotateWith(chooseRotateMethod(n, n - k % n, size), base, n, size, k);
+}
+
+// Function to rotate array to the right by k steps
+void rotateArray(int arr[], int n, int k) {
+    if (n <= 0) {
+        return;
+    }
+    
+    // Handle k greater than the array length, and negative k (left rotation)
+    k = k % n;
+    if (k < 0) {
+        k += n;
+    }
+    
+    rotateElements(arr, (size_t)n, sizeof(int), (size_t)k);
+}
+
+// ---------------------------------------------------------------------------
+// File-backed arrays
+// ---------------------------------------------------------------------------
+
+// Map a file of fixed-size records read/write. The kernel pages it in and
+// out as the rotation streams over it, so the file can be larger than RAM.
+static char* mapArrayFile(const char* path, size_t size, size_t* count, size_t* bytes) {
+    int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        printf("Error: Cannot open '%s'\n", path);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0 || (size_t)st.st_size % size != 0) {
+        printf("Error: '%s' is not a whole number of %zu-byte elements\n", path, size);
+        close(fd);
+        return NULL;
+    }
+    *bytes = (size_t)st.st_size;
+    *count = *bytes / size;
+    char* base = mmap(NULL, *bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        printf("Error: Cannot map '%s'\n", path);
+        return NULL;
+    }
+    return base;
+}
+
+static int unmapArrayFile(char* base, size_t bytes) {
+    int result = msync(base, bytes, MS_SYNC);
+    munmap(base, bytes);
+    if (result != 0) {
+        printf("Error: Cannot write the file back\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Rotate the records of a file to the right by k (negative k: left) in place
+int rotateFile(const char* path, size_t size, long long k) {
+    size_t n, bytes;
+    char* base = mapArrayFile(path, size, &n, &bytes);
+    if (base == NULL) {
+        return -1;
+    }
+    long long shift = k % (long long)n;
+    if (shift < 0) {
+        shift += (long long)n;
+    }
+    RotateMethod method = chooseRotateMethod(n, n - (size_t)shift, size);
+    madvise(base, bytes, MADV_SEQUENTIAL);
+    rotateWith(method, base, n, size, (size_t)shift);
+    printf("Rotated %zu elements of %zu bytes right by %lld (%s)\n", n, size, shift,
+           shift ? rotateMethodNames[method] : "nothing to do");
+    return unmapArrayFile(base, bytes);
+}
+
+// Reverse the records of a file in place
+int reverseFile(const char* path, size_t size, int threads) {
+    size_t n, bytes;
+    char* base = mapArrayFile(path, size, &n, &bytes);
+    if (base == NULL) {
+        return -1;
+    }
+    madvise(base, bytes, MADV_SEQUENTIAL);
+    reverseParallel(base, n, size, threads);
+    printf("Reversed %zu elements of %zu bytes\n", n, size);
+    return unmapArrayFile(base, bytes);
+}
+
 // Function to print array
 void printArray(int arr[], int n) {
     printf("[");
@@ -79,7 +552,188 @@ void printArray(int arr[], int n) {
     printf("]");
 }
 
-int main() {
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Fill element j with bytes derived from j, so misplaced elements show up
+static void fillPattern(unsigned char* base, size_t n, size_t size) {
+    for (size_t j = 0; j < n; j++) {
+        for (size_t b = 0; b < size; b++) {
+            base[j * size + b] = (unsigned char)(j * 31 + b * 7 + (j >> 8));
+        }
+    }
+}
+
+// Does base hold the pattern, reversed or not?
+static int checkPattern(const unsigned char* base, size_t n, size_t size, int reversed) {
+    for (size_t i = 0; i < n; i++) {
+        size_t j = reversed ? n - 1 - i : i;
+        for (size_t b = 0; b < size; b++) {
+            if (base[i * size + b] != (unsigned char)(j * 31 + b * 7 + (j >> 8))) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static void benchmarkReverse(size_t size_mb, int threads) {
+    size_t bytes = size_mb << 20;
+    unsigned char* data = malloc(bytes);
+    if (data == NULL) {
+        printf("Error: Out of memory\n");
+        return;
+    }
+    size_t sizes[] = {1, 2, 4, 8, 16, 12};
+    double mb = size_mb;
+
+    printf("%zu MB, %d threads for the parallel column\n", size_mb, threads);
+    printf("%-6s %14s %12s %14s %8s\n", "size", "scalar_MB/s", "simd_MB/s", "parallel_MB/s", "ok");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t size = sizes[s];
+        size_t n = bytes / size;
+        fillPattern(data, n, size);
+
+        double start = nowSeconds();
+        reversePairsScalar((char*)data, (char*)data + n * size, n / 2, size);
+        double scalar = nowSeconds() - start;
+        int ok = checkPattern(data, n, size, 1);
+
+        start = nowSeconds();
+        reverseElements(data, n, size);
+        double simd = nowSeconds() - start;
+        ok = ok && checkPattern(data, n, size, 0);
+
+        start = nowSeconds();
+        reverseParallel(data, n, size, threads);
+        double parallel = nowSeconds() - start;
+        ok = ok && checkPattern(data, n, size, 1);
+
+        printf("%-6zu %14.0f %12.0f %14.0f %8s\n", size, mb / scalar, mb / simd, mb / parallel,
+               ok ? "yes" : "NO");
+    }
+
+    // The original int reverse() for reference
+    int* ints = (int*)data;
+    int count = (int)(bytes / sizeof(int));
+    double start = nowSeconds();
+    reverse(ints, 0, count - 1);
+    printf("reverse(int[]) as before: %.0f MB/s\n", mb / (nowSeconds() - start));
+    free(data);
+}
+
+// Bytes read + written, in multiples of the array size
+static double rotateTraffic(RotateMethod method, size_t n, size_t k) {
+    size_t d = n - k;
+    size_t smaller = d < k ? d : k;
+    switch (method) {
+        case ROTATE_REVERSAL:
+            return 4.0;                            // Two full swap passes
+        case ROTATE_BUFFER:
+            return 2.0 + 2.0 * smaller / n;        // memmove + copy out/in
+        case ROTATE_JUGGLING:
+            return 2.0;                            // But one cache line per move
+        case ROTATE_BLOCK_SWAP: {
+            // Replay the swap sizes of rotateBlockSwap()
+            size_t left = d, right = k;
+            double bytes = 0.0;
+            while (left != right) {
+                size_t less = left < right ? left : right;
+                if (less * sizeof(int) <= ROTATE_BUFFER_BYTES) {
+                    return (bytes + 2.0 * (left + right) + 2.0 * less) / n;
+                }
+                bytes += 4.0 * less;
+                if (left < right) {
+                    right -= left;
+                } else {
+                    left -= right;
+                }
+            }
+            return (bytes + 4.0 * left) / n;
+        }
+    }
+    return 0.0;
+}
+
+static void benchmarkRotation(size_t millions) {
+    size_t n = millions * 1000000;
+    int* arr = malloc(n * sizeof(int));
+    if (arr == NULL) {
+        printf("Error: Out of memory\n");
+        return;
+    }
+    size_t shifts[] = {1, 1000, 100000, n / 3, n / 2 + 7};
+    double mb = n * sizeof(int) / (1024.0 * 1024.0);
+
+    printf("n = %zu ints (%.0f MB)\n", n, mb);
+    printf("%-12s %-15s %10s %10s %12s %6s\n", "k", "method", "seconds", "MB/s", "traffic(xn)", "ok");
+    for (size_t s = 0; s < sizeof(shifts) / sizeof(shifts[0]); s++) {
+        size_t k = shifts[s];
+        size_t smaller = k < n - k ? k : n - k;
+        RotateMethod chosen = chooseRotateMethod(n, n - k, sizeof(int));
+        for (int m = ROTATE_REVERSAL; m <= ROTATE_BLOCK_SWAP; m++) {
+            if (m == ROTATE_BUFFER && smaller * sizeof(int) > ROTATE_BUFFER_BYTES) {
+                continue;                          // Not applicable
+            }
+            if (m == ROTATE_JUGGLING && n > 100000000) {
+                continue;                          // Too slow to wait for
+            }
+            for (size_t i = 0; i < n; i++) {
+                arr[i] = (int)i;
+            }
+            double start = nowSeconds();
+            rotateWith((RotateMethod)m, arr, n, sizeof(int), k);
+            double seconds = nowSeconds() - start;
+            int ok = 1;
+            for (size_t i = 0; i < n; i++) {
+                if (arr[(i + k) % n] != (int)i) {
+                    ok = 0;
+                    break;
+                }
+            }
+            char label[32];
+            snprintf(label, sizeof(label), "%s%s", rotateMethodNames[m], m == (int)chosen ? " (*)" : "");
+            printf("%-12zu %-15s %10.3f %10.0f %12.2f %6s\n", k, label, seconds, mb / seconds,
+                   rotateTraffic((RotateMethod)m, n, k), ok ? "yes" : "NO");
+        }
+    }
+    printf("(*) = picked by rotateArray(); reversal uses the vectorized reverse\n");
+    free(arr);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        benchmarkRotation(argc >= 3 ? (size_t)atol(argv[2]) : 64);
+        return 0;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench-reverse") == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        benchmarkReverse(argc >= 3 ? (size_t)atol(argv[2]) : 256,
+                         argc >= 4 ? atoi(argv[3]) : (int)(cpus > 0 ? cpus : 1));
+        return 0;
+    }
+    if (argc >= 5 && strcmp(argv[1], "--rotate-file") == 0) {
+        long size = atol(argv[3]);
+        if (size <= 0) {
+            printf("Error: Element size must be positive\n");
+            return 1;
+        }
+        return rotateFile(argv[2], (size_t)size, atoll(argv[4])) == 0 ? 0 : 1;
+    }
+    if (argc >= 4 && strcmp(argv[1], "--reverse-file") == 0) {
+        long size = atol(argv[3]);
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        if (size <= 0) {
+            printf("Error: Element size must be positive\n");
+            return 1;
+        }
+        int threads = argc >= 5 ? atoi(argv[4]) : (int)(cpus > 0 ? cpus : 1);
+        return reverseFile(argv[2], (size_t)size, threads) == 0 ? 0 : 1;
+    }
+    
     printf("=== Array Rotation Problem ===\n");
     
     // Test Case 1
@@ -116,17 +770,32 @@ int main() {
     printf("=== Interactive Test ===\n");
     printf("Enter array size: ");
     int n;
-    scanf("%d", &n);
+    if (scanf("%d", &n) != 1 || n <= 0) {
+        printf("Error: Array size must be a positive number\n");
+        return 1;
+    }
     
-    int arr[100];
+    int* arr = malloc((size_t)n * sizeof(int));
+    if (arr == NULL) {
+        printf("Error: Out of memory\n");
+        return 1;
+    }
     printf("Enter %d elements: ", n);
     for (int i = 0; i < n; i++) {
-        scanf("%d", &arr[i]);
+        if (scanf("%d", &arr[i]) != 1) {
+            printf("Error: Expected %d numbers\n", n);
+            free(arr);
+            return 1;
+        }
     }
     
     printf("Enter number of rotations: ");
     int k;
-    scanf("%d", &k);
+    if (scanf("%d", &k) != 1) {
+        printf("Error: Invalid number of rotations\n");
+        free(arr);
+        return 1;
+    }
     
     printf("Original array: ");
     printArray(arr, n);
@@ -138,5 +807,6 @@ int main() {
     printArray(arr, n);
     printf("\n");
     
+    free(arr);
     return 0;
 }
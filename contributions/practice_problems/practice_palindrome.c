@@ -21,10 +21,25 @@
  * Approach: 
  * 1. Convert string to lowercase
  * 2. Remove non-alphanumeric characters
+ *    (both are single table lookups, see practice_charClass.h)
  * 3. Compare characters from start and end moving inward
  * 
- * Time Complexity: O(n) where n is the length of the string
- * Space Complexity: O(1) - using constant extra space
+ * For multi-MB records isPalindromeFast() does the same with AVX2, 32 bytes
+ * from each end per step: the right block is byte-reversed with a shuffle,
+ * both blocks are case-folded and classified with range compares, and when
+ * either block contains non-alphanumerics its alphanumerics are compacted
+ * (8-byte pshufb lookup table) into small queues that are compared instead.
+ * Fully alphanumeric blocks (DNA, identifiers) skip the queues entirely.
+ * 
+ * For bulk text, analyzePalindromes() goes beyond yes/no: with the same
+ * normalization it finds the longest palindromic substring and counts all
+ * palindromic substrings of a line using Manacher's algorithm, which reuses
+ * the mirror of each centre inside the rightmost palindrome found so far so
+ * that every character is compared O(1) times. analyzeFile() streams a file
+ * in 8 MB batches and shares each batch's lines between worker threads.
+ * 
+ * Time Complexity: O(n) where n is the length of the string (also for Manacher)
+ * Space Complexity: O(1) - using constant extra space (Manacher: O(n) per thread)
  * 
  * Test Cases:
  * - "racecar" -> Palindrome
@@ -33,19 +48,50 @@
  * - "hello" -> Not a palindrome
  * - "" -> Palindrome (empty string)
  * - "a" -> Palindrome (single character)
+ * - Randomized: isPalindromeFast() must agree with isPalindrome() on
+ *   100000 generated strings (./palindrome --bench [SIZE_MB] also times both
+ *   on DNA and punctuated text records)
+ * - ./palindrome --bench-class [SIZE_MB] checks the practice_charClass.h
+ *   table against the range compares and <ctype.h> for all 256 bytes, then
+ *   times the three on random bytes and on English-like text
+ * - "xyzracecarxy" -> longest "racecar", 15 palindromic substrings
+ * - ./palindrome --analyze FILE [THREADS] prints, per line: line number,
+ *   palindromic substring count, longest length (letters) and the longest
+ *   span as written; --bench-analyze [LINES] checks the engine against a
+ *   quadratic reference and times 1/2/4 threads (build with -pthread)
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "practice_charClass.h"
 
 // Function to check if a character is alphanumeric
 int isAlphanumeric(char c) {
-    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+    return charIsAlnum(c);
 }
 
 // Function to convert character to lowercase
 char toLower(char c) {
+    return charFold(c);
+}
+
+// Original range-compare versions, kept as the benchmark baseline
+static int isAlphanumericBranch(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+static char toLowerBranch(char c) {
     if (c >= 'A' && c <= 'Z') {
         return c + 32;
     }
@@ -81,9 +127,838 @@ int isPalindrome(char* str) {
     return 1; // Is a palindrome
 }
 
-int main() {
+// Same check over a length-delimited buffer (no strlen, no int overflow)
+static int isPalindromeN(const char* str, size_t len) {
+    size_t left = 0;
+    size_t right = len;
+
+    while (left + 1 < right) {
+        while (left + 1 < right && !isAlphanumeric(str[left])) {
+            left++;
+        }
+        while (left + 1 < right && !isAlphanumeric(str[right - 1])) {
+            right--;
+        }
+        if (toLower(str[left]) != toLower(str[right - 1])) {
+            return 0;
+        }
+        left++;
+        right--;
+    }
+    return 1;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_BLOCK 32
+
+// For each 8-bit mask: pshufb control that moves the selected bytes to the
+// front (unused slots read as zero)
+static uint64_t compactTable[256];
+
+static void buildCompactTable(void) {
+    for (int mask = 0; mask < 256; mask++) {
+        uint64_t control = 0;
+        int k = 0;
+        for (int bit = 0; bit < 8; bit++) {
+            if (mask & (1 << bit)) {
+                control |= (uint64_t)bit << (8 * k++);
+            }
+        }
+        for (; k < 8; k++) {
+            control |= (uint64_t)0x80 << (8 * k);
+        }
+        compactTable[mask] = control;
+    }
+}
+
+// Lower-case A-Z and report which bytes are [0-9A-Za-z]. Each range test
+// is an unsigned "c - lo <= hi - lo" done with min_epu8 + cmpeq.
+__attribute__((target("avx2")))
+static __m256i foldBlock(__m256i v, uint32_t* alnum) {
+    __m256i upper = _mm256_sub_epi8(v, _mm256_set1_epi8('A'));
+    upper = _mm256_cmpeq_epi8(_mm256_min_epu8(upper, _mm256_set1_epi8(25)), upper);
+    __m256i folded = _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+    __m256i alpha = _mm256_sub_epi8(folded, _mm256_set1_epi8('a'));
+    alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(25)), alpha);
+    __m256i digit = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+    digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    *alnum = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(alpha, digit));
+    return folded;
+}
+
+// Byte-reverse 32 bytes: reverse within each 128-bit lane, then swap lanes
+__attribute__((target("avx2")))
+static __m256i reverseBlock(__m256i v) {
+    const __m256i reverse = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                             15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    v = _mm256_shuffle_epi8(v, reverse);
+    return _mm256_permute2x128_si256(v, v, 1);
+}
+
+// Append the alphanumeric bytes of a folded block to out (needs 8 bytes of
+// slack past the result); returns how many were written
+__attribute__((target("avx2")))
+static size_t compactBlock(__m256i folded, uint32_t alnum, unsigned char* out) {
+    unsigned char bytes[SIMD_BLOCK];
+    size_t count = 0;
+    _mm256_storeu_si256((__m256i*)bytes, folded);
+    for (int group = 0; group < 4; group++) {
+        unsigned mask = (alnum >> (8 * group)) & 0xff;
+        __m128i chunk = _mm_loadl_epi64((const __m128i*)(bytes + 8 * group));
+        __m128i control = _mm_cvtsi64_si128((long long)compactTable[mask]);
+        _mm_storel_epi64((__m128i*)(out + count), _mm_shuffle_epi8(chunk, control));
+        count += (size_t)__builtin_popcount(mask);
+    }
+    return count;
+}
+
+__attribute__((target("avx2")))
+static int isPalindromeAvx2(const char* str, size_t len) {
+    // front holds alphanumerics taken from the left, back those taken from
+    // the right (already reversed); their common prefix must match
+    unsigned char front[2 * SIMD_BLOCK + 8];
+    unsigned char back[2 * SIMD_BLOCK + 8];
+    size_t front_count = 0, back_count = 0;
+    size_t lo = 0, hi = len;        // Bytes not yet loaded: [lo, hi)
+    uint32_t front_mask, back_mask;
+
+    for (;;) {
+        if (front_count == 0 && back_count == 0 && hi - lo >= 2 * SIMD_BLOCK) {
+            __m256i a = foldBlock(_mm256_loadu_si256((const __m256i*)(str + lo)), &front_mask);
+            __m256i b = foldBlock(reverseBlock(_mm256_loadu_si256((const __m256i*)(str + hi - SIMD_BLOCK))),
+                                  &back_mask);
+            if ((front_mask & back_mask) == 0xffffffffu) {
+                // Both blocks fully alphanumeric: compare directly
+                if ((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) != 0xffffffffu) {
+                    return 0;
+                }
+                lo += SIMD_BLOCK;
+                hi -= SIMD_BLOCK;
+                continue;
+            }
+            front_count = compactBlock(a, front_mask, front);
+            back_count = compactBlock(b, back_mask, back);
+            lo += SIMD_BLOCK;
+            hi -= SIMD_BLOCK;
+        } else if (front_count <= back_count && hi - lo >= SIMD_BLOCK) {
+            __m256i a = foldBlock(_mm256_loadu_si256((const __m256i*)(str + lo)), &front_mask);
+            front_count += compactBlock(a, front_mask, front + front_count);
+            lo += SIMD_BLOCK;
+        } else if (back_count < front_count && hi - lo >= SIMD_BLOCK) {
+            __m256i b = foldBlock(reverseBlock(_mm256_loadu_si256((const __m256i*)(str + hi - SIMD_BLOCK))),
+                                  &back_mask);
+            back_count += compactBlock(b, back_mask, back + back_count);
+            hi -= SIMD_BLOCK;
+        } else {
+            break;
+        }
+
+        size_t common = front_count < back_count ? front_count : back_count;
+        if (memcmp(front, back, common) != 0) {
+            return 0;
+        }
+        memmove(front, front + common, front_count - common);
+        memmove(back, back + common, back_count - common);
+        front_count -= common;
+        back_count -= common;
+    }
+
+    // What is left: queued front, the unloaded middle, queued back reversed
+    unsigned char rest[2 * SIMD_BLOCK + 8 + SIMD_BLOCK + 2 * SIMD_BLOCK + 8];
+    size_t count = 0;
+    memcpy(rest, front, front_count);
+    count = front_count;
+    for (size_t i = lo; i < hi; i++) {
+        if (isAlphanumeric(str[i])) {
+            rest[count++] = (unsigned char)toLower(str[i]);
+        }
+    }
+    while (back_count > 0) {
+        rest[count++] = back[--back_count];
+    }
+    for (size_t i = 0, j = count; i + 1 < j; i++, j--) {
+        if (rest[i] != rest[j - 1]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+#endif
+
+// Same result as isPalindrome(), vectorized when the CPU has AVX2
+int isPalindromeFast(const char* str, size_t len) {
+#if defined(__x86_64__) || defined(__i386__)
+    static int simd = -1;
+    if (simd < 0) {
+        simd = __builtin_cpu_supports("avx2") ? 1 : 0;
+        if (simd) {
+            buildCompactTable();
+        }
+    }
+    if (simd) {
+        return isPalindromeAvx2(str, len);
+    }
+#endif
+    return isPalindromeN(str, len);
+}
+
+// ---------------------------------------------------------------------------
+// Manacher engine: longest palindromic substring and palindrome counts
+// ---------------------------------------------------------------------------
+
+// Scratch buffers reused across lines so bulk runs do not allocate per line
+typedef struct {
+    char* text;          // Normalized (alphanumeric, folded) characters
+    size_t* offset;      // offset[i] = position of text[i] in the original line
+    size_t* odd;         // odd[i]  = number of odd palindromes centred at i
+    size_t* even;        // even[i] = number of even palindromes centred before i
+    size_t capacity;
+} ManacherWork;
+
+typedef struct {
+    size_t start;        // Longest palindrome, as a span of the original line
+    size_t length;       // (0 when the line has no alphanumerics)
+    size_t letters;      // Alphanumerics in that span
+    uint64_t count;      // Palindromic substrings of the normalized line
+} PalindromeStats;
+
+static void manacherFree(ManacherWork* work) {
+    free(work->text);
+    free(work->offset);
+    free(work->odd);
+    free(work->even);
+    memset(work, 0, sizeof(*work));
+}
+
+static int manacherReserve(ManacherWork* work, size_t len) {
+    if (len <= work->capacity) {
+        return 0;
+    }
+    size_t capacity = work->capacity ? work->capacity : 256;
+    while (capacity < len) {
+        capacity *= 2;
+    }
+    char* text = realloc(work->text, capacity);
+    if (text != NULL) {
+        work->text = text;
+    }
+    size_t* offset = realloc(work->offset, capacity * sizeof(size_t));
+    if (offset != NULL) {
+        work->offset = offset;
+    }
+    size_t* odd = realloc(work->odd, capacity * sizeof(size_t));
+    if (odd != NULL) {
+        work->odd = odd;
+    }
+    size_t* even = realloc(work->even, capacity * sizeof(size_t));
+    if (even != NULL) {
+        work->even = even;
+    }
+    if (text == NULL || offset == NULL || odd == NULL || even == NULL) {
+        return -1;
+    }
+    work->capacity = capacity;
+    return 0;
+}
+
+// Analyze one line with the same normalization as isPalindrome(): skip
+// non-alphanumerics, compare case-insensitively. Returns -1 when out of memory.
+int analyzePalindromes(const char* line, size_t len, ManacherWork* work, PalindromeStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (manacherReserve(work, len) != 0) {
+        return -1;
+    }
+
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (charIsAlnum(line[i])) {
+            work->text[n] = charFold(line[i]);
+            work->offset[n++] = i;
+        }
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    const char* s = work->text;
+    size_t* odd = work->odd;
+    size_t* even = work->even;
+    size_t best_start = 0, best_letters = 1;
+    uint64_t count = 0;
+
+    // Odd lengths: [left, right) is the rightmost palindrome found so far
+    size_t left = 0, right = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t k = 1;
+        if (i < right) {
+            k = odd[left + right - 1 - i];
+            if (k > right - i) {
+                k = right - i;
+            }
+        }
+        while (k <= i && i + k < n && s[i - k] == s[i + k]) {
+            k++;
+        }
+        odd[i] = k;
+        count += k;
+        if (i + k > right) {
+            left = i + 1 - k;
+            right = i + k;
+        }
+        if (2 * k - 1 > best_letters) {
+            best_letters = 2 * k - 1;
+            best_start = i + 1 - k;
+        }
+    }
+
+    // Even lengths: centre between i - 1 and i
+    left = 0;
+    right = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t k = 0;
+        if (i < right) {
+            k = even[left + right - i];
+            if (k > right - i) {
+                k = right - i;
+            }
+        }
+        while (k < i && i + k < n && s[i - k - 1] == s[i + k]) {
+            k++;
+        }
+        even[i] = k;
+        count += k;
+        if (i + k > right) {
+            left = i - k;
+            right = i + k;
+        }
+        if (2 * k > best_letters || (2 * k == best_letters && i - k < best_start)) {
+            best_letters = 2 * k;
+            best_start = i - k;
+        }
+    }
+
+    stats->start = work->offset[best_start];
+    stats->length = work->offset[best_start + best_letters - 1] + 1 - stats->start;
+    stats->letters = best_letters;
+    stats->count = count;
+    return 0;
+}
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t nextRandom(uint64_t* state) {
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+    return *state >> 33;
+}
+
+// Build a palindrome of about `size` bytes. With `punctuate`, the letters
+// get random case and random separators (and high bytes) in between.
+static char* makePalindrome(size_t size, int punctuate, uint64_t* state) {
+    static const char dna[] = "ACGT";
+    static const char separators[] = " ,.;'!-?\t\x80\xe9";
+    char* text = malloc(size + 64);
+    size_t half = punctuate ? size / 4 : size / 2;
+    char* core = malloc(half + 1);
+    if (text == NULL || core == NULL) {
+        free(text);
+        free(core);
+        return NULL;
+    }
+    for (size_t i = 0; i < half; i++) {
+        core[i] = punctuate ? "abcdefghijklmnopqrstuvwxyz0123456789"[nextRandom(state) % 36]
+                            : dna[nextRandom(state) % 4];
+    }
+    size_t n = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t k = 0; k < half; k++) {
+            char c = core[pass == 0 ? k : half - 1 - k];
+            if (punctuate) {
+                if (nextRandom(state) % 2) {
+                    c = (char)toupper((unsigned char)c);
+                }
+                if (nextRandom(state) % 3 == 0) {
+                    text[n++] = separators[nextRandom(state) % (sizeof(separators) - 1)];
+                }
+            }
+            text[n++] = c;
+        }
+    }
+    text[n] = '\0';
+    free(core);
+    return text;
+}
+
+static void benchmarkPalindrome(size_t size_mb) {
+    uint64_t state = 12345;
+
+    // Randomized agreement test on short strings
+    static const char alphabet[] = "aAbB0 ,.\x80\xff";
+    char sample[320];
+    int mismatches = 0;
+    for (int t = 0; t < 100000; t++) {
+        size_t len = nextRandom(&state) % 300;
+        for (size_t i = 0; i < len; i++) {
+            sample[i] = alphabet[nextRandom(&state) % (sizeof(alphabet) - 1)];
+        }
+        if (t % 2) {
+            for (size_t i = 0; i < len / 2; i++) {
+                sample[len - 1 - i] = sample[i];
+            }
+        }
+        sample[len] = '\0';
+        if ((isPalindrome(sample) != 0) != (isPalindromeFast(sample, len) != 0)) {
+            mismatches++;
+        }
+    }
+    printf("Randomized agreement: %s (%d mismatches in 100000)\n", mismatches ? "FAILED" : "ok", mismatches);
+
+    size_t size = size_mb << 20;
+    const char* names[] = {"DNA palindrome", "punctuated text palindrome", "DNA, mismatch in the middle"};
+    printf("%-30s %12s %12s %8s %8s\n", "input", "scalar_MB/s", "simd_MB/s", "speedup", "result");
+    for (int kind = 0; kind < 3; kind++) {
+        char* text = makePalindrome(size, kind == 1, &state);
+        if (text == NULL) {
+            printf("Error: Out of memory\n");
+            return;
+        }
+        size_t len = strlen(text);
+        if (kind == 2) {
+            text[len / 2 - 1] = text[len / 2 - 1] == 'A' ? 'C' : 'A';
+        }
+        double start = nowSeconds();
+        int scalar = isPalindrome(text);
+        double scalar_seconds = nowSeconds() - start;
+        start = nowSeconds();
+        int fast = isPalindromeFast(text, len);
+        double fast_seconds = nowSeconds() - start;
+        double mb = len / (1024.0 * 1024.0);
+        printf("%-30s %12.0f %12.0f %7.1fx %8s\n", names[kind], mb / scalar_seconds, mb / fast_seconds,
+               scalar_seconds / fast_seconds, scalar == fast ? (fast ? "yes" : "no") : "DIFFER");
+        free(text);
+    }
+}
+
+// One pass of classify + fold over the buffer; the multiply (rather than an
+// if) keeps the caller's own branch out of the measurement
+#define CLASS_PASS(name, isAlnumFn, foldFn)                          \
+    static uint64_t name(const char* text, size_t len) {            \
+        uint64_t sum = 0;                                           \
+        for (size_t i = 0; i < len; i++) {                          \
+            sum += (uint64_t)(isAlnumFn(text[i]) != 0)              \
+                   * (unsigned char)foldFn(text[i]);                \
+        }                                                           \
+        return sum;                                                 \
+    }
+
+static int ctypeIsAlnum(char c) {
+    return isalnum((unsigned char)c);
+}
+
+static char ctypeToLower(char c) {
+    return (char)tolower((unsigned char)c);
+}
+
+CLASS_PASS(classPassBranch, isAlphanumericBranch, toLowerBranch)
+CLASS_PASS(classPassCtype, ctypeIsAlnum, ctypeToLower)
+CLASS_PASS(classPassTable, charIsAlnum, charFold)
+
+static void benchmarkCharClass(size_t size_mb) {
+    // Exhaustive agreement over every byte value
+    int mismatches = 0;
+    for (int b = 0; b < 256; b++) {
+        char c = (char)b;
+        int alnum = charIsAlnum(c) != 0;
+        if (alnum != (isAlphanumericBranch(c) != 0) || alnum != (isalnum(b) != 0) ||
+            (charIsAlpha(c) != 0) != (isalpha(b) != 0) || (charIsDigit(c) != 0) != (isdigit(b) != 0) ||
+            (charIsSpace(c) != 0) != (isspace(b) != 0) || charFold(c) != toLowerBranch(c) ||
+            (unsigned char)charFold(c) != tolower(b)) {
+            mismatches++;
+        }
+    }
+    printf("Agreement over 256 byte values: %s (%d mismatches)\n", mismatches ? "FAILED" : "ok", mismatches);
+
+    size_t len = size_mb << 20;
+    char* text = malloc(len);
+    if (text == NULL) {
+        printf("Error: Out of memory\n");
+        return;
+    }
+    static const char prose[] = "The quick brown Fox, 42 times: jumps over the lazy dog!\n";
+    const char* inputs[] = {"random bytes", "English-like text"};
+    const char* names[] = {"range compares", "<ctype.h>", "lookup table"};
+    uint64_t (*passes[])(const char*, size_t) = {classPassBranch, classPassCtype, classPassTable};
+    uint64_t state = 777;
+
+    printf("%-18s %-16s %10s %18s\n", "input", "classifier", "MB/s", "checksum");
+    for (int in = 0; in < 2; in++) {
+        for (size_t i = 0; i < len; i++) {
+            text[i] = in == 0 ? (char)nextRandom(&state) : prose[i % (sizeof(prose) - 1)];
+        }
+        for (int p = 0; p < 3; p++) {
+            uint64_t sum = 0;
+            double seconds = 1e9;
+            for (int round = 0; round < 3; round++) {    // Best of 3
+                double start = nowSeconds();
+                sum = passes[p](text, len);
+                double elapsed = nowSeconds() - start;
+                seconds = elapsed < seconds ? elapsed : seconds;
+            }
+            printf("%-18s %-16s %10.0f %18llu\n", inputs[in], names[p], size_mb / seconds,
+                   (unsigned long long)sum);
+        }
+    }
+    free(text);
+}
+
+// ---------------------------------------------------------------------------
+// Batch driver: stream a file, analyze its lines on several threads
+// ---------------------------------------------------------------------------
+
+#define ANALYZE_BATCH_BYTES (8u << 20)
+#define ANALYZE_CHUNK_LINES 256
+
+typedef struct {
+    const char* text;
+    size_t len;
+    PalindromeStats stats;
+} LineJob;
+
+typedef struct {
+    LineJob* jobs;
+    size_t job_count;
+    size_t next_job;             // Claimed ANALYZE_CHUNK_LINES at a time
+    int failed;
+} AnalyzeBatch;
+
+typedef struct {
+    AnalyzeBatch* batch;
+    ManacherWork work;           // Kept across batches
+} AnalyzeWorker;
+
+static void* analyzeWorker(void* arg) {
+    AnalyzeWorker* worker = arg;
+    AnalyzeBatch* batch = worker->batch;
+    for (;;) {
+        size_t first = __atomic_fetch_add(&batch->next_job, ANALYZE_CHUNK_LINES, __ATOMIC_RELAXED);
+        if (first >= batch->job_count) {
+            return NULL;
+        }
+        size_t last = first + ANALYZE_CHUNK_LINES < batch->job_count ? first + ANALYZE_CHUNK_LINES
+                                                                      : batch->job_count;
+        for (size_t j = first; j < last; j++) {
+            if (analyzePalindromes(batch->jobs[j].text, batch->jobs[j].len, &worker->work,
+                                   &batch->jobs[j].stats) != 0) {
+                __atomic_store_n(&batch->failed, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+}
+
+static void analyzeJobs(AnalyzeBatch* batch, AnalyzeWorker* workers, int threads) {
+    pthread_t ids[64];
+    int started = 0;
+    batch->next_job = 0;
+    for (int t = 1; t < threads; t++) {
+        workers[t].batch = batch;
+        if (pthread_create(&ids[started], NULL, analyzeWorker, &workers[t]) == 0) {
+            started++;
+        }
+    }
+    workers[0].batch = batch;
+    analyzeWorker(&workers[0]);          // The calling thread works too
+    for (int t = 0; t < started; t++) {
+        pthread_join(ids[t], NULL);
+    }
+}
+
+typedef struct {
+    size_t lines;
+    size_t bytes;
+    uint64_t palindromes;
+    size_t best_line;            // 1-based, 0 = none
+    size_t best_letters;
+    char best_text[128];
+} AnalyzeTotals;
+
+// Print one result line per input line (unless quiet) and fold it into totals
+static void reportJobs(const AnalyzeBatch* batch, AnalyzeTotals* totals, FILE* out) {
+    for (size_t j = 0; j < batch->job_count; j++) {
+        const LineJob* job = &batch->jobs[j];
+        totals->lines++;
+        totals->bytes += job->len + 1;
+        totals->palindromes += job->stats.count;
+        if (out != NULL) {
+            fprintf(out, "%zu\t%llu\t%zu\t%.*s\n", totals->lines, (unsigned long long)job->stats.count,
+                    job->stats.letters, (int)job->stats.length, job->text + job->stats.start);
+        }
+        if (job->stats.letters > totals->best_letters) {
+            size_t shown = job->stats.length < sizeof(totals->best_text) - 1 ? job->stats.length
+                                                                             : sizeof(totals->best_text) - 1;
+            totals->best_letters = job->stats.letters;
+            totals->best_line = totals->lines;
+            memcpy(totals->best_text, job->text + job->stats.start, shown);
+            totals->best_text[shown] = '\0';
+        }
+    }
+}
+
+// Analyze every line of `path`. Reads ANALYZE_BATCH_BYTES at a time, cut at
+// the last newline; the tail is carried into the next batch. Lines within a
+// batch are independent, so they are shared out between `threads` workers
+// and reported in input order once the batch is done.
+int analyzeFile(const char* path, int threads, FILE* out, AnalyzeTotals* totals) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("Error: Cannot open '%s'\n", path);
+        return -1;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > 64) {
+        threads = 64;
+    }
+
+    size_t capacity = ANALYZE_BATCH_BYTES;
+    char* buffer = malloc(capacity);
+    size_t job_capacity = 4096;
+    AnalyzeBatch batch = {0};
+    batch.jobs = malloc(job_capacity * sizeof(LineJob));
+    AnalyzeWorker workers[64];
+    memset(workers, 0, sizeof(workers));
+    memset(totals, 0, sizeof(*totals));
+    int result = 0;
+    if (buffer == NULL || batch.jobs == NULL) {
+        printf("Error: Out of memory\n");
+        result = -1;
+    }
+
+    size_t filled = 0;
+    int at_eof = 0;
+    while (result == 0 && !(at_eof && filled == 0)) {
+        if (!at_eof) {
+            size_t got = fread(buffer + filled, 1, capacity - filled, file);
+            filled += got;
+            if (got == 0) {
+                if (ferror(file)) {
+                    printf("Error: Cannot read '%s'\n", path);
+                    result = -1;
+                    break;
+                }
+                at_eof = 1;
+            }
+        }
+
+        // Complete lines end at the last newline (or at EOF)
+        size_t end = filled;
+        while (end > 0 && buffer[end - 1] != '\n') {
+            end--;
+        }
+        if (at_eof) {
+            end = filled;
+        } else if (end == 0) {
+            if (filled < capacity) {
+                continue;                        // Short read, keep reading
+            }
+            char* grown = realloc(buffer, capacity * 2);    // One line > buffer
+            if (grown == NULL) {
+                printf("Error: Out of memory\n");
+                result = -1;
+                break;
+            }
+            buffer = grown;
+            capacity *= 2;
+            continue;
+        }
+
+        batch.job_count = 0;
+        for (size_t pos = 0; pos < end;) {
+            const char* newline = memchr(buffer + pos, '\n', end - pos);
+            size_t stop = newline != NULL ? (size_t)(newline - buffer) : end;
+            if (batch.job_count == job_capacity) {
+                LineJob* grown = realloc(batch.jobs, job_capacity * 2 * sizeof(LineJob));
+                if (grown == NULL) {
+                    printf("Error: Out of memory\n");
+                    result = -1;
+                    break;
+                }
+                batch.jobs = grown;
+                job_capacity *= 2;
+            }
+            size_t len = stop - pos;
+            if (len > 0 && buffer[stop - 1] == '\r') {
+                len--;
+            }
+            batch.jobs[batch.job_count].text = buffer + pos;
+            batch.jobs[batch.job_count].len = len;
+            batch.job_count++;
+            pos = stop + 1;
+        }
+        if (result != 0) {
+            break;
+        }
+
+        analyzeJobs(&batch, workers, threads);
+        if (batch.failed) {
+            printf("Error: Out of memory\n");
+            result = -1;
+            break;
+        }
+        reportJobs(&batch, totals, out);
+
+        memmove(buffer, buffer + end, filled - end);
+        filled -= end;
+    }
+
+    for (int t = 0; t < threads; t++) {
+        manacherFree(&workers[t].work);
+    }
+    free(batch.jobs);
+    free(buffer);
+    fclose(file);
+    return result;
+}
+
+// Quadratic reference: expand around every centre of the normalized line
+static void naivePalindromes(const char* line, size_t len, PalindromeStats* stats) {
+    char text[512];
+    size_t offset[512];
+    size_t n = 0;
+    memset(stats, 0, sizeof(*stats));
+    for (size_t i = 0; i < len && n < sizeof(text); i++) {
+        if (isAlphanumericBranch(line[i])) {
+            text[n] = toLowerBranch(line[i]);
+            offset[n++] = i;
+        }
+    }
+    size_t best_start = 0, best_letters = 0;
+    for (size_t start = 0; start < n; start++) {
+        for (size_t end = start; end < n; end++) {
+            size_t i = start, j = end;
+            while (i < j && text[i] == text[j]) {
+                i++;
+                j--;
+            }
+            if (i >= j) {
+                stats->count++;
+                if (end - start + 1 > best_letters) {
+                    best_letters = end - start + 1;
+                    best_start = start;
+                }
+            }
+        }
+    }
+    if (best_letters > 0) {
+        stats->start = offset[best_start];
+        stats->length = offset[best_start + best_letters - 1] + 1 - stats->start;
+        stats->letters = best_letters;
+    }
+}
+
+static void benchmarkAnalyze(size_t line_count) {
+    uint64_t state = 4242;
+
+    // Agreement with the quadratic reference on short noisy lines
+    static const char alphabet[] = "abAB1 ,.\x80";
+    ManacherWork work = {0};
+    char line[256];
+    int mismatches = 0;
+    for (int t = 0; t < 20000; t++) {
+        size_t len = nextRandom(&state) % 200;
+        for (size_t i = 0; i < len; i++) {
+            line[i] = alphabet[nextRandom(&state) % (sizeof(alphabet) - 1)];
+        }
+        PalindromeStats fast, slow;
+        if (analyzePalindromes(line, len, &work, &fast) != 0) {
+            printf("Error: Out of memory\n");
+            manacherFree(&work);
+            return;
+        }
+        naivePalindromes(line, len, &slow);
+        if (fast.count != slow.count || fast.letters != slow.letters || fast.start != slow.start ||
+            fast.length != slow.length) {
+            mismatches++;
+        }
+    }
+    manacherFree(&work);
+    printf("Agreement with quadratic reference: %s (%d mismatches in 20000)\n",
+           mismatches ? "FAILED" : "ok", mismatches);
+
+    // Generated corpus: mostly text, with planted palindromes
+    char path[] = "/tmp/palindrome_benchXXXXXX";
+    int fd = mkstemp(path);
+    FILE* file = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (file == NULL) {
+        printf("Error: Cannot create a temporary file\n");
+        return;
+    }
+    static const char* words[] = {"level", "the", "Racecar", "data", "noon", "ab", "42", "madam,", "report",
+                                  "x"};
+    for (size_t l = 0; l < line_count; l++) {
+        int word_count = 4 + (int)(nextRandom(&state) % 16);
+        for (int w = 0; w < word_count; w++) {
+            fprintf(file, "%s%s", w ? " " : "", words[nextRandom(&state) % 10]);
+        }
+        fputc('\n', file);
+    }
+    fclose(file);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int thread_counts[] = {1, 2, 4, (int)(cpus > 0 ? cpus : 1)};
+    printf("%-8s %12s %12s %16s\n", "threads", "lines/s", "MB/s", "palindromes");
+    for (int k = 0; k < 4; k++) {
+        if (k == 3 && thread_counts[3] <= 4) {
+            break;
+        }
+        AnalyzeTotals totals;
+        double start = nowSeconds();
+        if (analyzeFile(path, thread_counts[k], NULL, &totals) != 0) {
+            break;
+        }
+        double seconds = nowSeconds() - start;
+        printf("%-8d %12.0f %12.1f %16llu\n", thread_counts[k], totals.lines / seconds,
+               totals.bytes / (1024.0 * 1024.0) / seconds, (unsigned long long)totals.palindromes);
+    }
+    unlink(path);
+}
+
+int main(int argc, char* argv[]) {
     char str[1000];
     
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        benchmarkPalindrome(argc >= 3 ? (size_t)atol(argv[2]) : 64);
+        return 0;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench-class") == 0) {
+        benchmarkCharClass(argc >= 3 ? (size_t)atol(argv[2]) : 64);
+        return 0;
+    }
+    if (argc >= 3 && strcmp(argv[1], "--analyze") == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        int threads = argc >= 4 ? atoi(argv[3]) : (int)(cpus > 0 ? cpus : 1);
+        AnalyzeTotals totals;
+        double start = nowSeconds();
+        if (analyzeFile(argv[2], threads, stdout, &totals) != 0) {
+            return 1;
+        }
+        double seconds = nowSeconds() - start;
+        fprintf(stderr, "%zu lines, %llu palindromic substrings, %.1f MB/s\n", totals.lines,
+                (unsigned long long)totals.palindromes, totals.bytes / (1024.0 * 1024.0) / seconds);
+        if (totals.best_line > 0) {
+            fprintf(stderr, "Longest: %zu letters on line %zu: %s\n", totals.best_letters, totals.best_line,
+                    totals.best_text);
+        }
+        return 0;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench-analyze") == 0) {
+        benchmarkAnalyze(argc >= 3 ? (size_t)atol(argv[2]) : 1000000);
+        return 0;
+    }
+    
     printf("=== Palindrome Checker ===\n");
     printf("Enter a string: ");
     fgets(str, sizeof(str), stdin);
@@ -130,6 +130,9 @@ int factorial(int n) {
 }
 
 // Recursive function to calculate Fibonacci number
+// Each call makes two more, so the time grows exponentially with n (fine for
+// the first few numbers). algorithms/algorithms_fibonacci.c has O(n) and
+// O(log n) versions.
 int fibonacci(int n) {
     // Base cases
     if (n <= 1) {
@@ -193,6 +196,10 @@ void practiceExercise() {
     
     if (number < 0) {
         printf("Factorial is not defined for negative numbers!\n");
+    } else if (number > 12) {
+        // 13! no longer fits in an int
+        printf("%d! is too large for an int (12! is the limit).\n", number);
+        printf("basic_programs/basic_Factorial.c computes it exactly.\n");
     } else {
         printf("Factorial of %d = %d\n", number, factorial(number));
     }